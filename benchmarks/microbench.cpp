@@ -0,0 +1,307 @@
+/*
+    microbench.cpp -- Microbenchmarks of the hot kernels of the pipeline
+
+    Runs individual kernels on a fixed synthetic torus: the orientation and
+    position compatibility functions of the field solver, the kNN adjacency
+    of point clouds, the directed edge construction, the graph coloring and
+    the hierarchy downsampling. The input and the random fields are the
+    same on every run, so timings can be compared between builds. Every
+    kernel is repeated, and the minimum and median times are reported
+    together with the minimum in nanoseconds per input vertex. By default
+    the kernels run on a single thread, which gives the most repeatable
+    numbers; use --threads 0 for all hardware threads.
+
+    Usage: pyim_microbench [--faces N] [--repeat N] [--threads N]
+                           [--filter substring] [--csv]
+*/
+
+#include "common.h"
+#include "dedge.h"
+#include "dedge_parallel.h"
+#include "adjacency.h"
+#include "hierarchy.h"
+#include "hierarchy_radix.h"
+#include "meshstats_parallel.h"
+#include "field.h"
+#include "bvh.h"
+#include "logging.h"
+
+#include <pcg32.h>
+#include <tbb/task_scheduler_init.h>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <memory>
+
+namespace {
+
+// Synthetic input shared by all kernels
+struct BenchData {
+    MatrixXu F;
+    MatrixXf V, N, Q, O;
+    VectorXf A;
+    VectorXu V2E, E2E;
+    VectorXb boundary, nonManifold;
+    MeshStats stats;
+    AdjacencyMatrix adj = nullptr;
+    Float scale = 0;
+
+    ~BenchData() { free_adjacency(adj); }
+
+    static void free_adjacency(AdjacencyMatrix &adj) {
+        if (!adj)
+            return;
+        delete[] adj[0];
+        delete[] adj;
+        adj = nullptr;
+    }
+};
+
+struct Kernel {
+    const char *name;
+    std::function<void()> setup;      // untimed, before every repetition
+    std::function<void()> run;
+};
+
+/* Triangulated torus with about 'faceCount' faces and analytic normals. The
+   orientation field is random in the tangent planes, and the position field
+   is offset from the vertices by up to half the target edge length */
+void make_torus(uint32_t faceCount, BenchData &data) {
+    const uint32_t rings = std::max((uint32_t) std::sqrt(faceCount / 4.0), 3u),
+                   segments = 2 * rings, size = segments * rings;
+    const Float major = 3, minor = 1;
+
+    data.V.resize(3, size);
+    data.N.resize(3, size);
+    data.F.resize(3, 2 * size);
+    for (uint32_t i = 0; i < segments; ++i) {
+        for (uint32_t j = 0; j < rings; ++j) {
+            Float u = 2 * M_PI * i / segments, v = 2 * M_PI * j / rings;
+            Vector3f normal(std::cos(v) * std::cos(u), std::cos(v) * std::sin(u), std::sin(v));
+            uint32_t index = i * rings + j;
+            data.N.col(index) = normal;
+            data.V.col(index) = Vector3f(major * std::cos(u), major * std::sin(u), 0) + minor * normal;
+
+            uint32_t a = index, b = ((i + 1) % segments) * rings + j,
+                     c = ((i + 1) % segments) * rings + (j + 1) % rings,
+                     d = i * rings + (j + 1) % rings;
+            data.F.col(2 * index) << a, b, c;
+            data.F.col(2 * index + 1) << a, c, d;
+        }
+    }
+
+    data.stats = compute_mesh_stats(data.F, data.V, true);
+    data.scale = (Float) data.stats.mAverageEdgeLength * 4;
+    build_dedge_parallel(data.F, data.V, data.V2E, data.E2E, data.boundary, data.nonManifold);
+    compute_dual_vertex_areas_parallel(data.F, data.V, data.V2E, data.E2E, data.nonManifold,
+                                       VectorXf(), data.A);
+    data.adj = generate_adjacency_matrix_uniform(data.F, data.V2E, data.E2E, data.nonManifold);
+
+    pcg32 rng;
+    data.Q.resize(3, size);
+    data.O.resize(3, size);
+    for (uint32_t i = 0; i < size; ++i) {
+        Vector3f n = data.N.col(i), s, t;
+        coordinate_system(n, s, t);
+        Float angle = rng.nextFloat() * 2 * M_PI;
+        data.Q.col(i) = s * std::cos(angle) + t * std::sin(angle);
+        data.O.col(i) = data.V.col(i) + (s * (rng.nextFloat() - 0.5f) +
+                                         t * (rng.nextFloat() - 0.5f)) * data.scale;
+    }
+}
+
+/* Evaluate 'term(i, j)' for all links, parallel over vertices. The per-vertex
+   sums are kept so that the compiler cannot drop the evaluations */
+template <typename Term>
+void sum_over_links(const BenchData &data, VectorXf &out, const Term &term) {
+    const uint32_t size = (uint32_t) data.V.cols();
+    out.resize(size);
+    tbb::parallel_for(
+        tbb::blocked_range<uint32_t>(0u, size, GRAIN_SIZE),
+        [&](const tbb::blocked_range<uint32_t> &range) {
+            for (uint32_t i = range.begin(); i != range.end(); ++i) {
+                Float sum = 0;
+                for (const Link *link = data.adj[i]; link != data.adj[i + 1]; ++link)
+                    sum += term(i, link->id);
+                out[i] = sum;
+            }
+        }
+    );
+}
+
+std::vector<Kernel> make_kernels(BenchData &data, VectorXf &sink,
+                                 std::unique_ptr<MultiResolutionHierarchy> &mRes,
+                                 std::unique_ptr<BVH> &bvh) {
+    const MatrixXf &V = data.V, &N = data.N, &Q = data.Q, &O = data.O;
+    const Float scale = data.scale, inv_scale = 1 / scale;
+    auto none = []() { };
+
+    /* The hierarchy owns its adjacency, so every repetition gets a new one */
+    auto fresh_hierarchy = [&]() {
+        mRes.reset(new MultiResolutionHierarchy());
+        mRes->setAdj(generate_adjacency_matrix_uniform(data.F, data.V2E, data.E2E,
+                                                       data.nonManifold));
+        mRes->setF(MatrixXu(data.F));
+        mRes->setV(MatrixXf(data.V));
+        mRes->setA(VectorXf(data.A));
+        mRes->setN(MatrixXf(data.N));
+        mRes->setScale(scale);
+    };
+
+    std::vector<Kernel> kernels;
+    kernels.push_back({ "orientation_compat_intrinsic_4", none, [&]() {
+        sum_over_links(data, sink, [&](uint32_t i, uint32_t j) {
+            auto value = compat_orientation_intrinsic_4(Q.col(i), N.col(i), Q.col(j), N.col(j));
+            return value.first.dot(value.second);
+        });
+    }});
+    kernels.push_back({ "orientation_compat_extrinsic_4", none, [&]() {
+        sum_over_links(data, sink, [&](uint32_t i, uint32_t j) {
+            auto value = compat_orientation_extrinsic_4(Q.col(i), N.col(i), Q.col(j), N.col(j));
+            return value.first.dot(value.second);
+        });
+    }});
+    kernels.push_back({ "position_compat_intrinsic_4", none, [&]() {
+        sum_over_links(data, sink, [&](uint32_t i, uint32_t j) {
+            auto value = compat_position_intrinsic_4(V.col(i), N.col(i), Q.col(i), O.col(i),
+                                                     V.col(j), N.col(j), Q.col(j), O.col(j),
+                                                     scale, inv_scale);
+            return (value.first - value.second).squaredNorm();
+        });
+    }});
+    kernels.push_back({ "position_compat_extrinsic_4", none, [&]() {
+        sum_over_links(data, sink, [&](uint32_t i, uint32_t j) {
+            auto value = compat_position_extrinsic_4(V.col(i), N.col(i), Q.col(i), O.col(i),
+                                                     V.col(j), N.col(j), Q.col(j), O.col(j),
+                                                     scale, inv_scale);
+            return (value.first - value.second).squaredNorm();
+        });
+    }});
+    kernels.push_back({ "knn_adjacency", [&]() {
+        if (!bvh) {
+            static const MatrixXu noFaces;
+            bvh.reset(new BVH(&noFaces, &data.V, &data.N, data.stats.mAABB));
+            bvh->build();
+        }
+    }, [&]() {
+        AdjacencyMatrix adj = generate_adjacency_matrix_pointcloud(
+            data.V, data.N, bvh.get(), data.stats, 10, true);
+        BenchData::free_adjacency(adj);
+    }});
+    kernels.push_back({ "dedge_serial", none, [&]() {
+        VectorXu V2E, E2E;
+        VectorXb boundary, nonManifold;
+        build_dedge(data.F, data.V, V2E, E2E, boundary, nonManifold);
+    }});
+    kernels.push_back({ "dedge_parallel", none, [&]() {
+        VectorXu V2E, E2E;
+        VectorXb boundary, nonManifold;
+        build_dedge_parallel(data.F, data.V, V2E, E2E, boundary, nonManifold);
+    }});
+    kernels.push_back({ "graph_coloring", none, [&]() {
+        std::vector<std::vector<uint32_t>> phases;
+        generate_graph_coloring_deterministic(data.adj, (uint32_t) data.V.cols(), phases,
+                                              ProgressCallback());
+    }});
+    kernels.push_back({ "downsample_radix", none, [&]() {
+        MatrixXf V_p, N_p;
+        VectorXf A_p;
+        MatrixXu to_upper;
+        VectorXu to_lower;
+        AdjacencyMatrix adj_p = nullptr;
+        downsample_graph_radix(data.adj, data.V, data.N, data.A, V_p, N_p, A_p,
+                               to_upper, to_lower, adj_p);
+        BenchData::free_adjacency(adj_p);
+    }});
+    kernels.push_back({ "hierarchy_build", fresh_hierarchy, [&]() {
+        mRes->build(true);
+    }});
+    kernels.push_back({ "hierarchy_build_radix", fresh_hierarchy, [&]() {
+        build_hierarchy_radix(*mRes, true);
+    }});
+    return kernels;
+}
+
+void usage(const char *program) {
+    fprintf(stderr, "Usage: %s [--faces N] [--repeat N] [--threads N] "
+                    "[--filter substring] [--csv]\n", program);
+    exit(EXIT_FAILURE);
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+    uint32_t faces = 1000000, repeat = 10;
+    int threads = 1;
+    const char *filter = "";
+    bool csv = false;
+
+    for (int i = 1; i < argc; ++i) {
+        bool hasValue = i + 1 < argc;
+        if (strcmp(argv[i], "--faces") == 0 && hasValue)
+            faces = (uint32_t) atoi(argv[++i]);
+        else if (strcmp(argv[i], "--repeat") == 0 && hasValue)
+            repeat = std::max(atoi(argv[++i]), 1);
+        else if (strcmp(argv[i], "--threads") == 0 && hasValue)
+            threads = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--filter") == 0 && hasValue)
+            filter = argv[++i];
+        else if (strcmp(argv[i], "--csv") == 0)
+            csv = true;
+        else
+            usage(argv[0]);
+    }
+
+    tbb::task_scheduler_init init(threads > 0 ? threads : tbb::task_scheduler_init::automatic);
+    if (threads <= 0)
+        threads = tbb::task_scheduler_init::default_num_threads();
+
+    /* The kernels report their progress on std::cout; keep it out of the table */
+    BenchData data;
+    {
+        LogCapture capture;
+        make_torus(faces, data);
+    }
+    const uint32_t vertices = (uint32_t) data.V.cols();
+
+    if (csv)
+        printf("kernel,threads,vertices,min_ms,median_ms,ns_per_vertex\n");
+    else
+        printf("%u vertices, %u faces, %d thread(s), best of %u\n\n%-32s %10s %10s %12s\n",
+               vertices, (uint32_t) data.F.cols(), threads, repeat,
+               "kernel", "min [ms]", "median [ms]", "ns/vertex");
+
+    VectorXf sink;
+    std::unique_ptr<MultiResolutionHierarchy> mRes;
+    std::unique_ptr<BVH> bvh;
+    for (const Kernel &kernel : make_kernels(data, sink, mRes, bvh)) {
+        if (!strstr(kernel.name, filter))
+            continue;
+
+        std::vector<double> times;
+        for (uint32_t r = 0; r < repeat + 1; ++r) {
+            LogCapture capture;
+            kernel.setup();
+            auto begin = std::chrono::steady_clock::now();
+            kernel.run();
+            auto end = std::chrono::steady_clock::now();
+            if (r > 0) /* The first run warms up caches and the thread pool */
+                times.push_back(std::chrono::duration<double, std::nano>(end - begin).count());
+        }
+        mRes.reset();
+
+        std::sort(times.begin(), times.end());
+        double best = times.front(), median = times[times.size() / 2];
+        if (csv)
+            printf("%s,%d,%u,%.4f,%.4f,%.3f\n", kernel.name, threads, vertices,
+                   best * 1e-6, median * 1e-6, best / vertices);
+        else
+            printf("%-32s %10.3f %10.3f %12.3f\n", kernel.name, best * 1e-6,
+                   median * 1e-6, best / vertices);
+        fflush(stdout);
+    }
+    return EXIT_SUCCESS;
+}
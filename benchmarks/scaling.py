@@ -0,0 +1,188 @@
+"""
+Strong- and weak-scaling benchmark of pyinstantmeshes.remesh().
+
+Remeshes synthetic tori at a range of thread counts, set with
+``pyinstantmeshes.set_num_threads``. The timeline recorded by
+``start_trace`` is broken down into the top-level pipeline stages. For
+every stage, the benchmark reports how much faster it runs with more
+threads, which shows where the serial parts are (the OBJ round trip of the
+input, the directed edge construction, the extraction).
+
+Strong scaling keeps each input size fixed:
+    speedup = T(1) / T(n), efficiency = speedup / n
+Weak scaling grows the input with the thread count (--weak-faces per
+thread): efficiency = T(1) / T(n), speedup = n * efficiency
+
+Usage:
+    python benchmarks/scaling.py --sizes 50000,200000 --threads 1,2,4,8 \\
+        --csv scaling.csv --json scaling.json --option direct_solver=true
+"""
+
+import argparse
+import csv
+import json
+import os
+import platform
+import sys
+import time
+
+import numpy as np
+
+import pyinstantmeshes
+
+
+def torus(face_count, major=3.0, minor=1.0):
+    """Triangulated torus with about ``face_count`` faces."""
+    rings = max(int(np.sqrt(face_count / 4.0)), 3)
+    segments = 2 * rings
+    u = np.linspace(0, 2 * np.pi, segments, endpoint=False)
+    v = np.linspace(0, 2 * np.pi, rings, endpoint=False)
+    uu, vv = np.meshgrid(u, v, indexing="ij")
+    vertices = np.stack([(major + minor * np.cos(vv)) * np.cos(uu),
+                         (major + minor * np.cos(vv)) * np.sin(uu),
+                         minor * np.sin(vv)], axis=-1).reshape(-1, 3)
+
+    i, j = np.meshgrid(np.arange(segments), np.arange(rings), indexing="ij")
+    a = i * rings + j
+    b = ((i + 1) % segments) * rings + j
+    c = ((i + 1) % segments) * rings + (j + 1) % rings
+    d = i * rings + (j + 1) % rings
+    faces = np.concatenate([np.stack([a, b, c], axis=-1).reshape(-1, 3),
+                            np.stack([a, c, d], axis=-1).reshape(-1, 3)])
+    return vertices.astype(np.float32), faces.astype(np.int32)
+
+
+def stage_seconds(trace):
+    """Sum the durations of the top-level stages of the calling thread."""
+    events = [e for e in trace["traceEvents"] if e.get("ph") == "X"]
+    pipelines = [e for e in events if e["name"] == "remesh_pipeline"]
+    if not pipelines:
+        return {}
+    tid = pipelines[0]["tid"]
+    events = sorted((e for e in events if e["tid"] == tid),
+                    key=lambda e: (e["ts"], -e["dur"]))
+
+    # Stack of (end, name) of the enclosing events
+    stack, result = [], {}
+    for event in events:
+        while stack and stack[-1][0] <= event["ts"]:
+            stack.pop()
+        parent = stack[-1][1] if stack else None
+        if event["name"] != "remesh_pipeline" and parent in (None, "remesh_pipeline"):
+            result[event["name"]] = result.get(event["name"], 0.0) + event["dur"] * 1e-6
+        stack.append((event["ts"] + event["dur"], event["name"]))
+    return result
+
+
+def run(vertices, faces, threads, repeat, kwargs, traced):
+    """Best of ``repeat`` runs: (total seconds, {stage: seconds})."""
+    pyinstantmeshes.set_num_threads(threads)
+    best = None
+    for _ in range(repeat):
+        if traced:
+            pyinstantmeshes.start_trace()
+        start = time.perf_counter()
+        pyinstantmeshes.remesh(vertices, faces, **kwargs)
+        total = time.perf_counter() - start
+        stages = stage_seconds(pyinstantmeshes.stop_trace()) if traced else {}
+        if best is None or total < best[0]:
+            best = (total, stages)
+    return best
+
+
+def parse_list(text):
+    return [int(item) for item in text.split(",") if item]
+
+
+def parse_option(text):
+    key, _, value = text.partition("=")
+    try:
+        return key, json.loads(value)
+    except ValueError:
+        return key, value
+
+
+def default_threads():
+    count = os.cpu_count() or 1
+    threads = [1 << k for k in range(count.bit_length()) if (1 << k) <= count]
+    if threads[-1] != count:
+        threads.append(count)
+    return threads
+
+
+def main(argv=None):
+    parser = argparse.ArgumentParser(description=__doc__.strip().splitlines()[0])
+    parser.add_argument("--mode", choices=["strong", "weak", "both"], default="both")
+    parser.add_argument("--sizes", type=parse_list, default=[50000, 200000, 800000],
+                        help="input face counts for strong scaling")
+    parser.add_argument("--weak-faces", type=int, default=100000,
+                        help="input faces per thread for weak scaling")
+    parser.add_argument("--threads", type=parse_list, default=default_threads())
+    parser.add_argument("--repeat", type=int, default=3, help="best of this many runs")
+    parser.add_argument("--vertex-ratio", type=float, default=0.125,
+                        help="target vertex count relative to the input faces")
+    parser.add_argument("--option", action="append", default=[], type=parse_option,
+                        metavar="KEY=VALUE", help="extra remesh() argument (JSON value)")
+    parser.add_argument("--csv", help="write one row per mode, size, threads and stage")
+    parser.add_argument("--json", help="write the rows and the machine description")
+    args = parser.parse_args(argv)
+
+    traced = True
+    try:
+        pyinstantmeshes.start_trace()
+        pyinstantmeshes.stop_trace()
+    except RuntimeError:
+        print("Tracing is not available in this build; reporting totals only",
+              file=sys.stderr)
+        traced = False
+
+    options = dict(args.option)
+    threads = sorted(set(args.threads))
+    configs = []
+    if args.mode in ("strong", "both"):
+        configs += [("strong", size, t) for size in args.sizes for t in threads]
+    if args.mode in ("weak", "both"):
+        configs += [("weak", args.weak_faces * t, t) for t in threads]
+
+    rows, baseline = [], {}
+    for mode, size, t in configs:
+        vertices, faces = torus(size)
+        kwargs = dict(options, target_vertex_count=int(len(faces) * args.vertex_ratio),
+                      deterministic=True)
+        total, stages = run(vertices, faces, t, args.repeat, kwargs, traced)
+        stages = dict(stages, total=total)
+
+        # Reference: one thread at the same size (strong) or per-thread size (weak)
+        key = (mode, size if mode == "strong" else None)
+        if t == threads[0]:
+            baseline[key] = (t, stages)
+        base_threads, base = baseline[key]
+        for stage, seconds in sorted(stages.items()):
+            ratio = base.get(stage, seconds) / seconds if seconds > 0 else float("nan")
+            if mode == "strong":
+                speedup, efficiency = ratio, ratio * base_threads / t
+            else:
+                speedup, efficiency = ratio * t / base_threads, ratio
+            rows.append({"mode": mode, "input_faces": len(faces), "threads": t,
+                         "stage": stage, "seconds": seconds,
+                         "speedup": speedup, "efficiency": efficiency})
+        summary = next(row for row in rows[::-1] if row["stage"] == "total")
+        print("%-6s %9d faces %3d threads: %8.3f s  speedup %5.2f  efficiency %4.2f"
+              % (mode, len(faces), t, total, summary["speedup"], summary["efficiency"]),
+              flush=True)
+    pyinstantmeshes.set_num_threads(None)
+
+    if args.csv:
+        with open(args.csv, "w", newline="") as f:
+            writer = csv.DictWriter(f, fieldnames=list(rows[0]))
+            writer.writeheader()
+            writer.writerows(rows)
+    if args.json:
+        machine = {"cpu_count": os.cpu_count(), "platform": platform.platform(),
+                   "processor": platform.processor(), "python": platform.python_version()}
+        with open(args.json, "w") as f:
+            json.dump({"machine": machine, "options": options, "results": rows}, f, indent=1)
+
+
+if __name__ == "__main__":
+    main()
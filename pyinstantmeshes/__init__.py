@@ -18,7 +18,14 @@ Example:
     ... )
 """
 
-from ._pyinstantmeshes import remesh, remesh_file
+from ._backend import (get_num_threads, prepare_mesh, prepare_mesh_file, remesh_file,
+                       set_logger, set_num_threads, solver_control, start_trace,
+                       stop_trace)
+from .parallel import remesh
+from .sweep import remesh_sweep
+from .tiled import remesh_tiled
 
 __version__ = "0.1.0"
-__all__ = ["remesh", "remesh_file"]
+__all__ = ["get_num_threads", "prepare_mesh", "prepare_mesh_file", "remesh",
+           "remesh_file", "remesh_sweep", "remesh_tiled", "set_logger",
+           "set_num_threads", "solver_control", "start_trace", "stop_trace"]
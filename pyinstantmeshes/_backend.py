@@ -0,0 +1,207 @@
+"""
+Selection of the compiled backend by floating point precision.
+
+The package ships the same bindings compiled twice: ``_pyinstantmeshes``
+with instant-meshes in single precision and ``_pyinstantmeshes_f64`` in
+double precision. The double precision module is imported on first use.
+Each module has its own log sink; ``set_logger`` configures all of them.
+Likewise, ``start_trace`` and ``stop_trace`` cover every loaded module, and
+``set_num_threads`` limits the thread pool of each.
+"""
+
+import importlib
+import json
+import logging
+
+_MODULES = {
+    "float32": "_pyinstantmeshes",
+    "float64": "_pyinstantmeshes_f64",
+}
+
+
+#: Arguments of the native set_log_handler(), applied to every loaded backend
+_log_config = (None, logging.INFO)
+#: Per-thread event capacity while tracing, None when not tracing
+_trace_capacity = None
+#: Argument of the native set_num_threads(), 0 for no limit
+_thread_limit = 0
+_loaded = {}
+
+
+def get_backend(precision="float32"):
+    """Return the compiled module for ``precision`` ('float32' or 'float64')."""
+    if precision not in _MODULES:
+        raise ValueError("Unknown precision %r (expected 'float32' or 'float64')"
+                         % (precision,))
+    if precision in _loaded:
+        return _loaded[precision]
+    try:
+        module = importlib.import_module("." + _MODULES[precision], __package__)
+    except ImportError as error:
+        raise ImportError("The %s backend of pyinstantmeshes is not available; "
+                          "rebuild with PYIM_BUILD_DOUBLE_PRECISION=ON"
+                          % precision) from error
+    module.set_log_handler(*_log_config)
+    if _thread_limit > 0:
+        module.set_num_threads(_thread_limit)
+    if _trace_capacity is not None:
+        module.start_trace(_trace_capacity)
+    _loaded[precision] = module
+    return module
+
+
+def set_logger(logger=None, level=logging.INFO):
+    """
+    Send the progress output of the remeshing stages to a logger.
+
+    Parameters
+    ----------
+    logger : logging.Logger or str or None, optional
+        Logger (or logger name) that receives one record per line of
+        progress output. None silences the output, which is the default
+    level : int, optional
+        Minimum level of the forwarded records (default: logging.INFO).
+        Records below it are not even formatted by the native code
+    """
+    global _log_config
+    if isinstance(logger, str):
+        logger = logging.getLogger(logger)
+    handler = None
+    if logger is not None:
+        def handler(record_level, message, logger=logger):
+            logger.log(record_level, message)
+    _log_config = (handler, level)
+    for module in _loaded.values():
+        module.set_log_handler(handler, level)
+
+
+def set_num_threads(count=None):
+    """
+    Limit the number of threads that run the remeshing stages.
+
+    The limit applies process-wide to every precision backend, and is passed
+    on to the worker processes of ``workers > 1``.
+
+    Parameters
+    ----------
+    count : int or None, optional
+        Maximum number of threads, including the calling thread. None or 0
+        removes the limit, which is the default
+    """
+    global _thread_limit
+    count = int(count or 0)
+    if count < 0:
+        raise ValueError("count must not be negative")
+    _thread_limit = count
+    for module in _loaded.values():
+        module.set_num_threads(count)
+
+
+def get_num_threads():
+    """Return the thread limit, or the number of hardware threads without one."""
+    return get_backend("float32").get_num_threads()
+
+
+def start_trace(capacity=65536):
+    """
+    Start recording a timeline of the remeshing stages.
+
+    Every thread records the begin and end of the stages it runs (hierarchy
+    levels, solver sweeps, extraction steps, ...) into its own ring buffer.
+    Worker processes of ``workers > 1`` are not traced.
+
+    Parameters
+    ----------
+    capacity : int, optional
+        Number of events kept per thread; older events are overwritten
+        (default: 65536)
+    """
+    global _trace_capacity
+    if not get_backend("float32").tracing_available():
+        raise RuntimeError("pyinstantmeshes was built with PYIM_ENABLE_TRACING=OFF")
+    _trace_capacity = capacity
+    for module in _loaded.values():
+        module.start_trace(capacity)
+
+
+def stop_trace(path=None):
+    """
+    Stop recording and return the timeline as a Chrome trace.
+
+    Parameters
+    ----------
+    path : str, optional
+        If given, the trace is also written to this file as JSON, which
+        loads in Perfetto (ui.perfetto.dev) and chrome://tracing
+
+    Returns
+    -------
+    trace : dict
+        Chrome trace with a 'traceEvents' list. Every loaded precision
+        backend appears as its own process
+    """
+    global _trace_capacity
+    _trace_capacity = None
+    events = []
+    for pid, precision in enumerate(sorted(_loaded), start=1):
+        events.append({"name": "process_name", "ph": "M", "pid": pid,
+                       "args": {"name": "pyinstantmeshes (%s)" % precision}})
+        for event in _loaded[precision].stop_trace():
+            event["pid"] = pid
+            events.append(event)
+    trace = {"traceEvents": events, "displayTimeUnit": "ns"}
+    if path is not None:
+        with open(path, "w") as f:
+            json.dump(trace, f)
+    return trace
+
+
+def solver_control(precision="float32"):
+    """
+    Return a new ``SolverControl`` for ``remesh(..., solver_control=...)``.
+
+    The job runs without the GIL, so another Python thread can poll
+    ``control.sweeps`` and call ``control.cancel()``, which makes remesh()
+    raise RuntimeError before the next solver sweep. Each backend has its
+    own control type, so ``precision`` must match the one of the job.
+
+    precision : str, optional
+        'float32' or 'float64' (default: 'float32')
+    """
+    return get_backend(precision).SolverControl()
+
+
+def remesh_file(input_path, output_path, *args, precision="float32", **kwargs):
+    """
+    Remesh a mesh from an input file and save to an output file.
+
+    Takes the same arguments as the native remesh_file function (see
+    ``pyinstantmeshes._pyinstantmeshes.remesh_file``), plus:
+
+    precision : str, optional (keyword only)
+        Floating point precision of the solver and of the returned
+        vertices: 'float32' or 'float64' (default: 'float32')
+    """
+    return get_backend(precision).remesh_file(input_path, output_path,
+                                              *args, **kwargs)
+
+
+def prepare_mesh(vertices, faces, precision="float32"):
+    """
+    Load a mesh once for several remeshing runs.
+
+    The returned ``Mesh`` caches the mesh statistics and face areas, so
+    that ``mesh.remesh(**kwargs)`` calls with different targets skip the
+    pass that computes them. ``mesh.remesh`` takes the same keyword
+    arguments and returns the same values as the native remesh().
+
+    precision : str, optional (keyword only)
+        Floating point precision of the solver: 'float32' or 'float64'
+        (default: 'float32'). All runs of the mesh use this precision
+    """
+    return get_backend(precision).prepare_mesh(vertices, faces)
+
+
+def prepare_mesh_file(path, precision="float32"):
+    """Like ``prepare_mesh``, but load the mesh from a file (OBJ, PLY, etc.)."""
+    return get_backend(precision).prepare_mesh_file(path)
@@ -0,0 +1,319 @@
+"""
+Spatial partitioning helpers for remeshing large inputs piece by piece.
+
+The input is split along a regular grid over its bounding box. Every face
+is owned by the cell that contains its centroid, and each tile additionally
+sees the faces of its neighbors within a margin so that the field near the
+cell boundary is solved with the same context on both sides. After
+remeshing, each tile keeps only the output faces whose centroid lies in its
+own cell, and the open seams are closed by welding nearby boundary vertices
+of different tiles.
+
+All passes over the input stream through it in chunks of faces, so the
+input arrays may be ``numpy.memmap`` instances that do not fit in memory.
+"""
+
+import itertools
+import os
+
+import numpy as np
+
+#: Number of faces processed per streaming chunk
+CHUNK_SIZE = 1 << 22
+
+
+def _chunks(count):
+    for start in range(0, count, CHUNK_SIZE):
+        yield start, min(start + CHUNK_SIZE, count)
+
+
+def _as_triangles(faces):
+    """Split quads (0, 1, 2, 3) into the triangles (0, 1, 2) and (0, 2, 3)."""
+    if faces.shape[1] == 3:
+        return faces
+    return np.concatenate([faces[:, [0, 1, 2]], faces[:, [0, 2, 3]]])
+
+
+def check_face_format(kwargs):
+    """Reject face layouts that cannot be cropped and welded per tile."""
+    if kwargs.get("face_format", "triangles") == "csr":
+        raise ValueError("face_format='csr' is not supported for tiled or "
+                         "partitioned remeshing")
+
+
+def bounding_box(vertices):
+    """Return the (min, max) corners of the vertex positions."""
+    lo = np.full(3, np.inf)
+    hi = np.full(3, -np.inf)
+    for start, end in _chunks(len(vertices)):
+        chunk = np.asarray(vertices[start:end], dtype=np.float64)
+        lo = np.minimum(lo, chunk.min(axis=0))
+        hi = np.maximum(hi, chunk.max(axis=0))
+    return lo, hi
+
+
+def surface_area(vertices, faces):
+    """Total area of a triangle or quad mesh."""
+    area = 0.0
+    for start, end in _chunks(len(faces)):
+        tris = _as_triangles(np.asarray(faces[start:end]))
+        p = [np.asarray(vertices[tris[:, i]], dtype=np.float64) for i in range(3)]
+        area += 0.5 * np.linalg.norm(np.cross(p[1] - p[0], p[2] - p[0]), axis=1).sum()
+    return area
+
+
+def target_edge_length(area, vertex_count, posy=4, target_vertex_count=-1,
+                       target_face_count=-1, target_edge_length=-1.0):
+    """Global output edge length, following the heuristics of remesh()."""
+    if target_edge_length > 0:
+        return float(target_edge_length)
+    if target_face_count > 0:
+        face_count = target_face_count
+    else:
+        if target_vertex_count <= 0:
+            target_vertex_count = vertex_count // 16
+        face_count = target_vertex_count if posy == 4 else 2 * target_vertex_count
+    face_area = area / max(face_count, 1)
+    if posy == 4:
+        return float(np.sqrt(face_area))
+    return float(2.0 * np.sqrt(face_area * np.sqrt(1.0 / 3.0)))
+
+
+class TileGrid:
+    """Regular grid of ``count`` or more cells over a bounding box.
+
+    Cells are added along the axis with the largest cell extent first, so
+    that the cells stay as close to cubes as possible.
+    """
+
+    def __init__(self, lo, hi, count):
+        self.lo = np.asarray(lo, dtype=np.float64)
+        extent = np.maximum(np.asarray(hi, dtype=np.float64) - self.lo, 1e-12)
+        shape = np.ones(3, dtype=np.int64)
+        while shape.prod() < count:
+            shape[np.argmax(extent / shape)] += 1
+        self.shape = shape
+        self.cell_size = extent / shape
+
+    def __len__(self):
+        return int(self.shape.prod())
+
+    def max_margin(self):
+        """Largest margin that ``cells_near`` accepts.
+
+        Only the axes split into several cells limit it: along the others,
+        every point lies in the single cell whatever the margin, and the
+        cell size of a flat axis is close to zero.
+        """
+        split = self.shape > 1
+        return float(self.cell_size[split].min()) if split.any() else np.inf
+
+    def _coords(self, points):
+        coords = np.floor((np.asarray(points, dtype=np.float64) - self.lo) / self.cell_size)
+        return np.clip(coords.astype(np.int64), 0, self.shape - 1)
+
+    def cell(self, points):
+        """Flat index of the cell containing each point."""
+        return np.ravel_multi_index(self._coords(points).T, self.shape)
+
+    def cells_near(self, points, margin):
+        """Flat indices of all cells within ``margin`` of each point.
+
+        Returns an (N, 8) array; slots that do not refer to a distinct
+        neighbor cell are -1. The margin must not exceed ``max_margin()``.
+        """
+        lower = self._coords(np.asarray(points) - margin)
+        upper = self._coords(np.asarray(points) + margin)
+        result = np.full((len(lower), 8), -1, dtype=np.int64)
+        for slot in range(8):
+            offset = np.array([(slot >> axis) & 1 for axis in range(3)])
+            coords = np.where(offset == 1, upper, lower)
+            valid = np.all((offset == 0) | (upper != lower), axis=1)
+            result[valid, slot] = np.ravel_multi_index(coords[valid].T, self.shape)
+        return result
+
+
+def face_centroids(vertices, faces):
+    """Centroids of a chunk of faces."""
+    faces = np.asarray(faces)
+    return np.mean([np.asarray(vertices[faces[:, i]], dtype=np.float64)
+                    for i in range(faces.shape[1])], axis=0)
+
+
+def partition_faces(vertices, faces, grid, margin, directory):
+    """Write the face indices seen by each tile to a file in ``directory``.
+
+    Returns the list of file paths (one per cell, in cell order) and the
+    number of faces stored in each of them.
+    """
+    paths = [os.path.join(directory, "tile_%d.idx" % i) for i in range(len(grid))]
+    counts = np.zeros(len(grid), dtype=np.int64)
+    handles = {}
+    try:
+        for start, end in _chunks(len(faces)):
+            near = grid.cells_near(face_centroids(vertices, faces[start:end]), margin)
+            ids = np.arange(start, end, dtype=np.int64)
+            for slot in range(near.shape[1]):
+                cells = near[:, slot]
+                order = np.argsort(cells, kind="stable")
+                cells, slot_ids = cells[order], ids[order]
+                splits = np.flatnonzero(np.diff(cells)) + 1
+                for group_cells, group_ids in zip(np.split(cells, splits),
+                                                  np.split(slot_ids, splits)):
+                    if len(group_cells) == 0 or group_cells[0] < 0:
+                        continue
+                    cell = int(group_cells[0])
+                    if cell not in handles:
+                        handles[cell] = open(paths[cell], "wb")
+                    group_ids.tofile(handles[cell])
+                    counts[cell] += len(group_ids)
+    finally:
+        for handle in handles.values():
+            handle.close()
+    return paths, counts
+
+
+def load_tile(vertices, faces, path, dtype=np.float32):
+    """Gather the compacted sub-mesh whose face indices are stored in ``path``."""
+    ids = np.sort(np.fromfile(path, dtype=np.int64))
+    tile_faces = np.asarray(faces[ids])
+    used, inverse = np.unique(tile_faces, return_inverse=True)
+    tile_vertices = np.asarray(vertices[used], dtype=dtype)
+    return tile_vertices, inverse.reshape(tile_faces.shape).astype(np.int32)
+
+
+def crop_to_cell(vertices, faces, grid, cell):
+    """Keep the faces whose centroid lies in ``cell`` and drop unused vertices."""
+    if len(faces) == 0:
+        return vertices[:0], faces
+    faces = faces[grid.cell(face_centroids(vertices, faces)) == cell]
+    used, inverse = np.unique(faces, return_inverse=True)
+    return vertices[used], inverse.reshape(faces.shape).astype(np.int32)
+
+
+def _boundary_vertices(faces):
+    """Vertices on edges that are used by a single face."""
+    n = faces.shape[1]
+    edges = np.concatenate([faces[:, [i, (i + 1) % n]] for i in range(n)]).astype(np.int64)
+    edges.sort(axis=1)
+    edges = edges[edges[:, 0] != edges[:, 1]]
+    keys = edges[:, 0] * (int(faces.max()) + 1) + edges[:, 1]
+    unique, index, counts = np.unique(keys, return_index=True, return_counts=True)
+    return np.unique(edges[index[counts == 1]])
+
+
+def _seam_partners(points, tile_of, distance):
+    """Closest point of another tile within ``distance`` of every point.
+
+    The points are bucketed on a grid of cell size ``distance``, so the
+    candidates of a point lie in the 27 cells around its own. Returns the
+    index of the partner of every point, or -1. Among equally close
+    candidates, the first one in cell offset order, then index order, wins.
+    """
+    keys = np.floor(points / distance).astype(np.int64)
+    cells, cell_of = np.unique(keys, axis=0, return_inverse=True)
+    cell_of = cell_of.ravel()
+    members = np.argsort(cell_of, kind="stable")
+    starts = np.searchsorted(cell_of[members], np.arange(len(cells) + 1))
+
+    # Cell index of every neighbor of every occupied cell, or -1
+    offsets = np.array(list(itertools.product((-1, 0, 1), repeat=3)))
+    queries = (cells[None, :, :] + offsets[:, None, :]).reshape(-1, 3)
+    _, inverse = np.unique(np.concatenate([cells, queries]), axis=0,
+                           return_inverse=True)
+    inverse = inverse.ravel()
+    index_of = np.full(len(cells) + len(queries), -1, dtype=np.int64)
+    index_of[inverse[:len(cells)]] = np.arange(len(cells))
+    neighbors = index_of[inverse[len(cells):]].reshape(len(offsets), len(cells))
+
+    # All candidate pairs (point, other), with their enumeration order
+    cell = neighbors[:, cell_of]
+    offset_of = np.broadcast_to(np.arange(len(offsets))[:, None], cell.shape)
+    point = np.broadcast_to(np.arange(len(points))[None, :], cell.shape)
+    valid = cell >= 0
+    cell, offset_of, point = cell[valid], offset_of[valid], point[valid]
+    sizes = starts[cell + 1] - starts[cell]
+    first = np.repeat(starts[cell] - np.cumsum(sizes) + sizes, sizes)
+    slot = np.arange(int(sizes.sum())) + first
+    point = np.repeat(point, sizes)
+    other = members[slot]
+    sequence = np.repeat(offset_of, sizes) * len(points) + other
+
+    keep = tile_of[point] != tile_of[other]
+    point, other, sequence = point[keep], other[keep], sequence[keep]
+    dist = np.linalg.norm(points[other] - points[point], axis=1)
+    keep = dist < distance
+    point, other, sequence, dist = point[keep], other[keep], sequence[keep], dist[keep]
+
+    order = np.lexsort((sequence, dist, point))
+    point, other = point[order], other[order]
+    first = np.ones(len(point), dtype=bool)
+    first[1:] = point[1:] != point[:-1]
+    partner = np.full(len(points), -1, dtype=np.int64)
+    partner[point[first]] = other[first]
+    return partner
+
+
+def _components(count, a, b):
+    """Smallest vertex of the connected component of every vertex.
+
+    Array-based union-find over the edges (a, b): every round hooks the
+    roots of both endpoints to the smaller one and compresses all paths.
+    """
+    parent = np.arange(count)
+    while True:
+        ra, rb = parent[a], parent[b]
+        low = np.minimum(ra, rb)
+        np.minimum.at(parent, ra, low)
+        np.minimum.at(parent, rb, low)
+        while True:
+            grand = parent[parent]
+            if np.array_equal(grand, parent):
+                break
+            parent = grand
+        if np.array_equal(parent[a], parent[b]):
+            return parent
+
+
+def weld_tiles(parts, distance):
+    """Merge the per-tile meshes in ``parts`` into a single mesh.
+
+    Boundary vertices of different tiles that are closer than ``distance``
+    are welded to their midpoint; faces that collapse are removed.
+    """
+    dtype = parts[0][0].dtype if parts else np.float32
+    parts = [(v, f) for v, f in parts if len(f) > 0]
+    if not parts:
+        return np.zeros((0, 3), dtype=dtype), np.zeros((0, 3), dtype=np.int32)
+    width = max(f.shape[1] for _, f in parts)
+
+    offsets = np.cumsum([0] + [len(v) for v, _ in parts])
+    vertices = np.concatenate([v for v, _ in parts]).astype(np.float64)
+    faces = np.concatenate([
+        (f if f.shape[1] == width else np.concatenate(
+            [f, f[:, -1:].repeat(width - f.shape[1], axis=1)], axis=1)) + offset
+        for (_, f), offset in zip(parts, offsets)])
+
+    seam = np.concatenate([_boundary_vertices(f) + offset
+                           for (_, f), offset in zip(parts, offsets)])
+    tile_of = np.searchsorted(offsets, seam, side="right") - 1
+
+    # Weld every seam vertex to its closest partner from another tile
+    partner = _seam_partners(vertices[seam], tile_of, distance)
+    matched = partner >= 0
+    parent = _components(len(vertices), seam[matched], seam[partner[matched]])
+
+    # Move welded vertices to their mean
+    sums = np.zeros_like(vertices)
+    np.add.at(sums, parent, vertices)
+    counts = np.bincount(parent, minlength=len(vertices))
+    roots = counts > 0
+    vertices[roots] = sums[roots] / counts[roots, None]
+
+    faces = parent[faces]
+    ordered = np.sort(faces, axis=1)
+    distinct = 1 + np.count_nonzero(np.diff(ordered, axis=1), axis=1)
+    faces = faces[distinct >= 3]
+    used, inverse = np.unique(faces, return_inverse=True)
+    return (vertices[used].astype(dtype),
+            inverse.reshape(faces.shape).astype(np.int32))
@@ -0,0 +1,133 @@
+"""
+Multi-process partitioned remeshing.
+
+With ``workers > 1``, ``remesh`` copies the input once into POSIX shared
+memory and partitions it spatially (see ``_partition``). Each partition is
+remeshed in its own worker process, which attaches to the shared input by
+name and gathers its faces from there, so the input is never pickled. Each
+process has its own allocator and thread pool, which avoids the contention
+of a single large process on multi-socket machines. The seams between
+partitions are reconciled in the parent process by welding.
+"""
+
+import multiprocessing
+import tempfile
+from concurrent.futures import ProcessPoolExecutor
+from multiprocessing import shared_memory
+
+import numpy as np
+
+from . import _backend, _partition
+from ._backend import get_backend, set_num_threads
+
+
+def _share(array):
+    """Copy an array into a new shared memory block."""
+    block = shared_memory.SharedMemory(create=True, size=max(array.nbytes, 1))
+    view = np.ndarray(array.shape, dtype=array.dtype, buffer=block.buf)
+    view[...] = array
+    del view
+    return block, (block.name, array.shape, array.dtype.str)
+
+
+def _attach(spec):
+    """Map the shared memory block described by ``spec`` as an array."""
+    name, shape, dtype = spec
+    block = shared_memory.SharedMemory(name=name)
+    return block, np.ndarray(shape, dtype=np.dtype(dtype), buffer=block.buf)
+
+
+def _remesh_partition(job):
+    """Worker: remesh one partition and crop it to its own cell."""
+    vertex_spec, face_spec, path, grid, cell, scale, precision, kwargs = job
+    vertex_block, vertices = _attach(vertex_spec)
+    face_block, faces = _attach(face_spec)
+    try:
+        tile_vertices, tile_faces = _partition.load_tile(vertices, faces, path,
+                                                         dtype=vertices.dtype)
+    finally:
+        del vertices, faces
+        vertex_block.close()
+        face_block.close()
+
+    result = get_backend(precision).remesh(tile_vertices, tile_faces,
+                                           target_edge_length=scale, **kwargs)
+    return _partition.crop_to_cell(result[0], result[1], grid, cell) + tuple(result[2:])
+
+
+def remesh_partitioned(vertices, faces, workers, precision="float32",
+                       target_vertex_count=-1, target_face_count=-1,
+                       target_edge_length=-1.0, **kwargs):
+    """Remesh spatial partitions of a mesh in ``workers`` processes."""
+    get_backend(precision)
+    _partition.check_face_format(kwargs)
+    vertices = np.ascontiguousarray(vertices, dtype=np.dtype(precision))
+    faces = np.ascontiguousarray(faces, dtype=np.int32)
+    if vertices.ndim != 2 or vertices.shape[1] != 3:
+        raise RuntimeError("Vertices must be a Nx3 array")
+    if faces.ndim != 2 or faces.shape[1] not in (3, 4):
+        raise RuntimeError("Faces must be a Nx3 or Nx4 array")
+
+    posy = kwargs.get("posy", 4)
+    scale = _partition.target_edge_length(
+        _partition.surface_area(vertices, faces), len(vertices), posy,
+        target_vertex_count, target_face_count, target_edge_length)
+    lo, hi = _partition.bounding_box(vertices)
+    grid = _partition.TileGrid(lo, hi, workers)
+    margin = min(4.0 * scale, grid.max_margin())
+
+    vertex_block, vertex_spec = _share(vertices)
+    face_block, face_spec = _share(faces)
+    try:
+        with tempfile.TemporaryDirectory(prefix="pyim_parts") as directory:
+            paths, counts = _partition.partition_faces(vertices, faces, grid,
+                                                       margin, directory)
+            jobs = [(vertex_spec, face_spec, path, grid, cell, scale, precision, kwargs)
+                    for cell, (path, count) in enumerate(zip(paths, counts))
+                    if count > 0]
+            # Workers are spawned rather than forked: the TBB thread pool of
+            # this process must not be inherited in an undefined state
+            context = multiprocessing.get_context("spawn")
+            with ProcessPoolExecutor(max_workers=workers, mp_context=context,
+                                     initializer=set_num_threads,
+                                     initargs=(_backend._thread_limit,)) as pool:
+                results = list(pool.map(_remesh_partition, jobs))
+    finally:
+        for block in (vertex_block, face_block):
+            block.close()
+            block.unlink()
+
+    out_vertices, out_faces = _partition.weld_tiles(
+        [result[:2] for result in results], 0.5 * scale)
+    if kwargs.get("return_stats", False):
+        return out_vertices, out_faces, {"partitions": [result[2] for result in results]}
+    return out_vertices, out_faces
+
+
+def remesh(vertices, faces, *args, workers=1, precision="float32", **kwargs):
+    """
+    Remesh a triangular or quad mesh for better topology.
+
+    Takes the same keyword arguments as the native remesh function (see
+    ``pyinstantmeshes._pyinstantmeshes.remesh``), plus:
+
+    workers : int, optional (keyword only)
+        Number of worker processes. With more than one, the mesh is split
+        into spatial partitions that are remeshed in parallel from shared
+        memory and welded along their seams (default: 1)
+    precision : str, optional (keyword only)
+        Floating point precision of the solver and of the returned
+        vertices: 'float32' or 'float64' (default: 'float32')
+
+    With ``return_stats=True`` and ``workers > 1``, the statistics are
+    returned per partition under the key 'partitions'.
+    """
+    if workers < 1:
+        raise ValueError("workers must be at least 1")
+    if workers == 1:
+        return get_backend(precision).remesh(vertices, faces, *args, **kwargs)
+    if args:
+        raise TypeError("remesh() with workers > 1 only accepts keyword arguments")
+    if kwargs.get("solver_control") is not None:
+        raise TypeError("solver_control is not available with workers > 1")
+    return remesh_partitioned(vertices, faces, workers, precision, **kwargs)
@@ -0,0 +1,89 @@
+"""
+Parameter sweeps with shared preprocessing.
+
+``remesh_sweep`` runs every combination of a parameter grid on one mesh in
+a single process. Combinations that agree on the options the preprocessing
+depends on share the adjacency, normals and hierarchy, which are computed
+once and only read by the jobs; the jobs then solve and extract in
+parallel. Varying ``rosy``, ``posy``, the targets or the solver settings
+therefore costs one preprocessing pass, and every distinct ``crease_angle``
+adds one.
+"""
+
+import itertools
+import time
+
+from ._backend import get_backend
+
+
+def expand_grid(param_grid):
+    """
+    List the parameter combinations of a grid.
+
+    ``param_grid`` maps parameter names to lists of values, and every
+    combination is returned in order, the last parameter varying fastest.
+    A list of such dicts is expanded dict by dict and concatenated.
+    """
+    if isinstance(param_grid, dict):
+        param_grid = [param_grid]
+    combinations = []
+    for grid in param_grid:
+        names = list(grid)
+        for values in itertools.product(*(grid[name] for name in names)):
+            combinations.append(dict(zip(names, values)))
+    return combinations
+
+
+def remesh_sweep(vertices, faces, param_grid, face_format="triangles",
+                 return_stats=False, precision="float32", **kwargs):
+    """
+    Remesh a mesh with every parameter combination of a grid.
+
+    Parameters
+    ----------
+    vertices : numpy.ndarray or Mesh
+        Input vertex positions as Nx3 float array, or a mesh returned by
+        ``prepare_mesh`` (then ``faces`` must be None)
+    faces : numpy.ndarray or None
+        Input face indices as Nx3 or Nx4 int array
+    param_grid : dict or list of dict
+        remesh() keyword arguments mapped to lists of values, e.g.
+        ``{"posy": [3, 4], "target_vertex_count": [1000, 5000]}``
+    face_format : str, optional
+        Layout of the returned faces, see remesh() (default: 'triangles')
+    return_stats : bool, optional
+        Add the statistics of every job, see remesh() (default: False)
+    precision : str, optional
+        Floating point precision: 'float32' or 'float64' (default:
+        'float32'). Ignored for a prepared mesh
+    **kwargs
+        remesh() keyword arguments shared by all combinations
+
+    Returns
+    -------
+    results : list of dict
+        One dict per combination, in the order of ``expand_grid``, with
+        'params' (the combination), 'vertices', 'faces', 'stats' (with
+        return_stats), 'group' (index of the shared preprocessing),
+        'seconds' (solve and extraction of the job) and
+        'preprocess_seconds' (shared preprocessing of its group)
+    timings : dict
+        'total' wall time of the sweep in seconds, 'groups' number of
+        distinct preprocessing passes
+    """
+    combinations = expand_grid(param_grid)
+    jobs = [dict(kwargs, **params) for params in combinations]
+
+    start = time.perf_counter()
+    if faces is None:
+        results = vertices.remesh_sweep(jobs, face_format=face_format,
+                                        return_stats=return_stats)
+    else:
+        results = get_backend(precision).remesh_sweep(
+            vertices, faces, jobs, face_format=face_format, return_stats=return_stats)
+    total = time.perf_counter() - start
+
+    for params, result in zip(combinations, results):
+        result["params"] = params
+    groups = len({result["group"] for result in results})
+    return results, {"total": total, "groups": groups}
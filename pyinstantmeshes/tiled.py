@@ -0,0 +1,91 @@
+"""
+Out-of-core tiled remeshing.
+
+``remesh_tiled`` remeshes inputs that are too large to be processed in one
+piece. The faces are partitioned on a regular grid (see ``_partition``),
+each tile is remeshed on its own with a common target edge length, and the
+tiles are stitched back together along their seams. Peak memory is bounded
+by the largest tile plus the output mesh, so the input arrays can be
+memory-mapped, e.g. with ``numpy.load(path, mmap_mode='r')``.
+"""
+
+import tempfile
+
+import numpy as np
+
+from . import _partition
+from ._backend import get_backend
+
+
+def remesh_tiled(vertices, faces, max_tile_faces=2000000, tile_margin=-1.0,
+                 weld_distance=-1.0, target_vertex_count=-1,
+                 target_face_count=-1, target_edge_length=-1.0, posy=4,
+                 precision="float32", **kwargs):
+    """
+    Remesh a large mesh tile by tile with bounded memory.
+
+    Parameters
+    ----------
+    vertices : array_like
+        Input vertex positions as Nx3 float array (may be a numpy.memmap)
+    faces : array_like
+        Input face indices as Nx3 or Nx4 int array (may be a numpy.memmap)
+    max_tile_faces : int, optional
+        Approximate number of input faces per tile (default: 2000000)
+    tile_margin : float, optional
+        Width of the overlap that each tile sees beyond its own cell
+        (default: -1, four target edge lengths)
+    weld_distance : float, optional
+        Maximum distance between seam vertices of adjacent tiles that are
+        merged (default: -1, half the target edge length)
+    target_vertex_count, target_face_count, target_edge_length : optional
+        Output size goals for the whole mesh, as in remesh()
+    posy : int, optional
+        Position symmetry type (default: 4)
+    precision : str, optional
+        Floating point precision of the solver and of the returned
+        vertices: 'float32' or 'float64' (default: 'float32')
+    **kwargs
+        Further keyword arguments passed to remesh() for every tile
+
+    Returns
+    -------
+    vertices : numpy.ndarray
+        Output vertex positions as Nx3 float array
+    faces : numpy.ndarray
+        Output face indices as Nx3 or Nx4 int array
+    """
+    if max_tile_faces < 1:
+        raise ValueError("max_tile_faces must be positive")
+    _partition.check_face_format(kwargs)
+    remesh = get_backend(precision).remesh
+
+    # Global statistics, so that all tiles agree on the output edge length
+    lo, hi = _partition.bounding_box(vertices)
+    area = _partition.surface_area(vertices, faces)
+    scale = _partition.target_edge_length(
+        area, len(vertices), posy, target_vertex_count, target_face_count,
+        target_edge_length)
+    if tile_margin < 0:
+        tile_margin = 4.0 * scale
+    if weld_distance < 0:
+        weld_distance = 0.5 * scale
+
+    grid = _partition.TileGrid(lo, hi, -(-len(faces) // max_tile_faces))
+    tile_margin = min(tile_margin, grid.max_margin())
+
+    parts = []
+    with tempfile.TemporaryDirectory(prefix="pyim_tiles") as directory:
+        paths, counts = _partition.partition_faces(vertices, faces, grid,
+                                                   tile_margin, directory)
+        for cell, (path, count) in enumerate(zip(paths, counts)):
+            if count == 0:
+                continue
+            tile_vertices, tile_faces = _partition.load_tile(
+                vertices, faces, path, dtype=np.dtype(precision))
+            out_vertices, out_faces = remesh(
+                tile_vertices, tile_faces, target_edge_length=scale, posy=posy,
+                **kwargs)[:2]
+            parts.append(_partition.crop_to_cell(out_vertices, out_faces, grid, cell))
+
+    return _partition.weld_tiles(parts, weld_distance)
@@ -0,0 +1,82 @@
+/*
+    arena.cpp -- Monotonic arena for the temporaries of a remeshing job
+*/
+
+#include "arena.h"
+
+#include <cstdlib>
+#include <algorithm>
+#include <new>
+
+#if defined(__GLIBC__)
+#include <malloc.h>
+#endif
+
+void *Arena::allocate(size_t size, size_t alignment) {
+    uintptr_t current = (uintptr_t) mCurrent;
+    uintptr_t aligned = (current + alignment - 1) & ~(uintptr_t) (alignment - 1);
+
+    if (!mCurrent || aligned + size > (uintptr_t) mEnd) {
+        /* Oversized requests get a block of their own */
+        size_t blockSize = std::max(mBlockSize, size + alignment);
+        char *block = (char *) std::malloc(blockSize);
+        if (!block)
+            throw std::bad_alloc();
+        mBlocks.push_back(block);
+        mReserved += blockSize;
+        mCurrent = block;
+        mEnd = block + blockSize;
+        current = (uintptr_t) mCurrent;
+        aligned = (current + alignment - 1) & ~(uintptr_t) (alignment - 1);
+    }
+
+    mCurrent = (char *) (aligned + size);
+    return (void *) aligned;
+}
+
+void Arena::release() {
+    for (char *block : mBlocks)
+        std::free(block);
+    mBlocks.clear();
+    mCurrent = mEnd = nullptr;
+    mReserved = 0;
+}
+
+void Arena::rewind(const Mark &mark) {
+    for (size_t i = mark.blocks; i < mBlocks.size(); ++i)
+        std::free(mBlocks[i]);
+    mBlocks.resize(mark.blocks);
+    mCurrent = mark.current;
+    mEnd = mark.end;
+    mReserved = mark.reserved;
+}
+
+Arena &JobArena::local() {
+    Arena *&arena = mLocal.local();
+    if (!arena)
+        arena = new Arena();
+    return *arena;
+}
+
+void JobArena::release() {
+    mShared.release();
+    for (Arena *&arena : mLocal) {
+        delete arena;
+        arena = nullptr;
+    }
+    mLocal.clear();
+}
+
+size_t JobArena::reserved() const {
+    size_t total = mShared.reserved();
+    for (Arena *arena : mLocal)
+        if (arena)
+            total += arena->reserved();
+    return total;
+}
+
+void trim_heap() {
+#if defined(__GLIBC__)
+    malloc_trim(0);
+#endif
+}
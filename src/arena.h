@@ -0,0 +1,142 @@
+/*
+    arena.h -- Monotonic arena for the temporaries of a remeshing job
+
+    Stages allocate their scratch buffers from the arena of the current job
+    instead of the global heap. Allocation is a pointer bump and
+    deallocation is a no-op; a stage opens an ArenaScope to hand everything
+    it allocated back in one shot when it is done, so that the buffers of
+    one stage do not stay alive for the rest of the job. TBB tasks use
+    per-thread sub-arenas so that they never contend on a lock, neither
+    here nor in malloc.
+*/
+
+#pragma once
+
+#include "common.h"
+#include <tbb/enumerable_thread_specific.h>
+#include <memory>
+
+class Arena {
+public:
+    static const size_t DEFAULT_BLOCK_SIZE = 1 << 20;
+
+    explicit Arena(size_t blockSize = DEFAULT_BLOCK_SIZE)
+        : mBlockSize(blockSize) { }
+    ~Arena() { release(); }
+
+    // Return 'size' bytes aligned to 'alignment' (a power of two)
+    void *allocate(size_t size, size_t alignment);
+
+    // Free all blocks at once; previously returned pointers become invalid
+    void release();
+
+    // Allocation state of the arena, see rewind()
+    struct Mark {
+        size_t blocks;
+        char *current, *end;
+        size_t reserved;
+    };
+
+    Mark mark() const { return Mark{mBlocks.size(), mCurrent, mEnd, mReserved}; }
+
+    // Free everything allocated since 'mark' was taken
+    void rewind(const Mark &mark);
+
+    // Number of bytes currently reserved from the system
+    size_t reserved() const { return mReserved; }
+
+private:
+    Arena(const Arena &) = delete;
+    Arena &operator=(const Arena &) = delete;
+
+    std::vector<char *> mBlocks;
+    char *mCurrent = nullptr, *mEnd = nullptr;
+    size_t mBlockSize, mReserved = 0;
+};
+
+// Arena of one job: a shared arena for the calling thread, plus sub-arenas for TBB workers
+class JobArena {
+public:
+    JobArena() { }
+    ~JobArena() { release(); }
+
+    // Arena for allocations made by the thread that runs the job
+    Arena &shared() { return mShared; }
+
+    // Arena of the calling thread, for allocations made inside TBB tasks
+    Arena &local();
+
+    void release();
+    size_t reserved() const;
+
+private:
+    JobArena(const JobArena &) = delete;
+    JobArena &operator=(const JobArena &) = delete;
+
+    Arena mShared;
+    tbb::enumerable_thread_specific<Arena *> mLocal;
+};
+
+/* Frees everything allocated from an arena during the lifetime of the
+   scope. Scopes on the same arena must be nested, and containers that use
+   the arena must be declared after the scope */
+class ArenaScope {
+public:
+    explicit ArenaScope(Arena *arena) : mArena(arena) {
+        if (mArena)
+            mMark = mArena->mark();
+    }
+    ~ArenaScope() {
+        if (mArena)
+            mArena->rewind(mMark);
+    }
+
+private:
+    ArenaScope(const ArenaScope &) = delete;
+    ArenaScope &operator=(const ArenaScope &) = delete;
+
+    Arena *mArena;
+    Arena::Mark mMark;
+};
+
+/* STL allocator on top of an arena. Without an arena it falls back to
+   std::allocator, so that stages can be called without a job context */
+template <typename T> class ArenaAllocator {
+public:
+    typedef T value_type;
+
+    ArenaAllocator(Arena *arena = nullptr) : mArena(arena) { }
+    template <typename U> ArenaAllocator(const ArenaAllocator<U> &other)
+        : mArena(other.arena()) { }
+
+    T *allocate(size_t n) {
+        if (mArena)
+            return (T *) mArena->allocate(n * sizeof(T), alignof(T));
+        return std::allocator<T>().allocate(n);
+    }
+
+    void deallocate(T *p, size_t n) {
+        if (!mArena)
+            std::allocator<T>().deallocate(p, n);
+    }
+
+    Arena *arena() const { return mArena; }
+
+private:
+    Arena *mArena;
+};
+
+template <typename T, typename U>
+inline bool operator==(const ArenaAllocator<T> &a, const ArenaAllocator<U> &b) {
+    return a.arena() == b.arena();
+}
+
+template <typename T, typename U>
+inline bool operator!=(const ArenaAllocator<T> &a, const ArenaAllocator<U> &b) {
+    return a.arena() != b.arena();
+}
+
+template <typename T> using ArenaVector = std::vector<T, ArenaAllocator<T>>;
+
+// Return free heap memory to the operating system (glibc only, no-op elsewhere)
+extern void trim_heap();
@@ -2,8 +2,8 @@
     bindings.cpp -- Python bindings for Instant Meshes
 
     This file provides Python bindings for the Instant Meshes remeshing library
-    using pybind11. It wraps the batch_process function to allow remeshing
-    from Python using numpy arrays.
+    using pybind11. It drives the batch stages through remesh_pipeline() to
+    allow remeshing from Python using numpy arrays.
 */
 
 #include <pybind11/pybind11.h>
@@ -11,14 +11,26 @@
 #include <pybind11/stl.h>
 
 #include "common.h"
-#include "batch.h"
-#include "meshio.h"
+#include "pipeline.h"
+#include "logging.h"
+#include "trace.h"
+#include "testing.h"
+
+#define TBB_PREVIEW_GLOBAL_CONTROL 1
+#include <tbb/global_control.h>
+#include <tbb/task_scheduler_init.h>
 
 #include <fstream>
+#include <iomanip>
+#include <limits>
+#include <future>
+#include <memory>
+#include <mutex>
 #include <sstream>
 #include <cstdlib>
 #include <random>
 #include <thread>
+#include <stdexcept>
 
 namespace py = pybind11;
 
@@ -81,7 +93,7 @@ static std::string generate_temp_filename(const std::string& prefix, const std::
 
 // Helper function to write mesh data to a temporary file
 static void write_temp_mesh(const std::string& filename,
-                           py::array_t<float> vertices,
+                           py::array_t<Float> vertices,
                            py::array_t<int> faces) {
     auto v = vertices.unchecked<2>();
     auto f = faces.unchecked<2>();
@@ -91,7 +103,8 @@ static void write_temp_mesh(const std::string& filename,
         throw std::runtime_error("Failed to open temporary file for writing: " + filename);
     }
     
-    // Write as OBJ format
+    // Write as OBJ format, with enough digits to round-trip Float exactly
+    out << std::setprecision(std::numeric_limits<Float>::max_digits10);
     out << "# Generated mesh for Instant Meshes processing\n";
     
     // Write vertices
@@ -111,53 +124,343 @@ static void write_temp_mesh(const std::string& filename,
     out.close();
 }
 
-// Helper function to read mesh data from a file
-static std::tuple<py::array_t<float>, py::array_t<int>> 
-read_temp_mesh(const std::string& filename) {
-    MatrixXu F;
-    MatrixXf V, N;
-    
-    load_mesh_or_pointcloud(filename, F, V, N);
-    
-    // Convert Eigen matrices to numpy arrays
-    py::array_t<float> vertices({static_cast<py::ssize_t>(V.cols()), 
-                                  static_cast<py::ssize_t>(V.rows())});
+// Layouts of the returned face list
+enum class FaceFormat {
+    Triangles,   // Nx3, as load_obj() reads the extracted mesh back
+    Quads,       // Nx'posy' as extracted, triangles repeat their last index
+    CSR          // (offsets, indices) pair without padding
+};
+
+static FaceFormat parse_face_format(const std::string &name) {
+    if (name == "triangles")
+        return FaceFormat::Triangles;
+    else if (name == "quads")
+        return FaceFormat::Quads;
+    else if (name == "csr")
+        return FaceFormat::CSR;
+    throw std::invalid_argument("Unknown face format \"" + name +
+                                "\" (expected 'triangles', 'quads' or 'csr')");
+}
+
+// Number of distinct corners of an extracted face (see RemeshOutput)
+static uint32_t face_size(const MatrixXu &F, uint32_t f) {
+    uint32_t n = (uint32_t) F.rows();
+    if (n == 4 && F(3, f) == F(2, f))
+        n = 3;
+    return n;
+}
+
+/* Expose a column-major matrix as a row-major (cols x rows) array. The data
+   is not copied; 'owner' keeps it alive for as long as the array exists */
+template <typename T, typename Matrix>
+static py::array_t<T> share_columns(Matrix &M, py::handle owner) {
+    std::vector<py::ssize_t> shape{(py::ssize_t) M.cols(), (py::ssize_t) M.rows()};
+    if (M.size() == 0)
+        return py::array_t<T>(shape);
+    return py::array_t<T>(shape, reinterpret_cast<T *>(M.data()), owner);
+}
+
+/* Convert the face list of an extracted mesh into the 'quads' or 'csr'
+   layout; 'triangles' is handled by triangulate_compact() */
+static py::object convert_faces(MatrixXu &F, FaceFormat format, py::handle owner) {
+    const uint32_t n = (uint32_t) F.cols();
+    if (format == FaceFormat::Quads)
+        return share_columns<int>(F, owner);
+
+    py::array_t<int64_t> offsets(n + 1);
+    auto o = offsets.mutable_unchecked<1>();
+    o(0) = 0;
+    for (uint32_t f = 0; f < n; ++f)
+        o(f + 1) = o(f) + face_size(F, f);
+    py::array_t<int> indices(o(n));
+    auto idx = indices.mutable_unchecked<1>();
+    for (uint32_t f = 0; f < n; ++f)
+        for (uint32_t i = 0; i < face_size(F, f); ++i)
+            idx(o(f) + i) = (int) F(i, f);
+    return py::make_tuple(offsets, indices);
+}
+
+/* Triangles and vertices of an extracted mesh as load_obj() returned them
+   when the mesh was read back from an OBJ file: a quad (a, b, c, d) becomes
+   the triangles (a, b, c) and (d, a, c), vertices are numbered in the order
+   of their first use, and unreferenced vertices are dropped */
+static py::tuple triangulate_compact(const RemeshOutput &mesh) {
+    const MatrixXu &F = mesh.F;
+    const uint32_t n = (uint32_t) F.cols();
+    static const int corners[2][3] = { { 0, 1, 2 }, { 3, 0, 2 } };
+
+    py::ssize_t count = 0;
+    for (uint32_t f = 0; f < n; ++f)
+        count += face_size(F, f) - 2;
+    py::array_t<int> triangles({count, (py::ssize_t) 3});
+    auto t = triangles.mutable_unchecked<2>();
+    std::vector<uint32_t> used;
+    std::vector<int> index(mesh.V.cols(), -1);
+    py::ssize_t k = 0;
+    for (uint32_t f = 0; f < n; ++f) {
+        for (uint32_t i = 0; i + 2 < face_size(F, f); ++i, ++k) {
+            for (int j = 0; j < 3; ++j) {
+                uint32_t v = F(corners[i][j], f);
+                if (index[v] < 0) {
+                    index[v] = (int) used.size();
+                    used.push_back(v);
+                }
+                t(k, j) = index[v];
+            }
+        }
+    }
+
+    py::array_t<Float> vertices({(py::ssize_t) used.size(), (py::ssize_t) 3});
     auto v = vertices.mutable_unchecked<2>();
-    for (py::ssize_t i = 0; i < V.cols(); ++i) {
-        for (py::ssize_t j = 0; j < V.rows(); ++j) {
-            v(i, j) = V(j, i);
+    for (size_t i = 0; i < used.size(); ++i)
+        for (int j = 0; j < 3; ++j)
+            v(i, j) = mesh.V(j, used[i]);
+    return py::make_tuple(vertices, triangles);
+}
+
+/* Forwards log records to a Python callable handler(level, message). Records
+   written by threads that do not hold the GIL (e.g. the Optimizer thread)
+   are queued and delivered by the next record or flush() on a Python thread */
+class PythonLogSink : public LogSink {
+public:
+    explicit PythonLogSink(py::function handler) : mHandler(std::move(handler)) { }
+
+    void write(LogLevel level, const std::string &message) override {
+        if (!PyGILState_Check()) {
+            std::lock_guard<std::mutex> lock(mMutex);
+            mPending.emplace_back(level, message);
+            return;
         }
+        flush();
+        deliver(level, message);
     }
-    
-    py::array_t<int> faces({static_cast<py::ssize_t>(F.cols()), 
-                            static_cast<py::ssize_t>(F.rows())});
-    auto f = faces.mutable_unchecked<2>();
-    for (py::ssize_t i = 0; i < F.cols(); ++i) {
-        for (py::ssize_t j = 0; j < F.rows(); ++j) {
-            f(i, j) = static_cast<int>(F(j, i));
+
+    // Deliver the queued records; requires the GIL
+    void flush() {
+        std::vector<std::pair<LogLevel, std::string>> pending;
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            pending.swap(mPending);
         }
+        for (const auto &record : pending)
+            deliver(record.first, record.second);
     }
-    
-    return std::make_tuple(vertices, faces);
+
+private:
+    void deliver(LogLevel level, const std::string &message) {
+        try {
+            mHandler((int) level, message);
+        } catch (py::error_already_set &error) {
+            // Logging must not abort the job; report like an exception in __del__
+            error.restore();
+            PyErr_WriteUnraisable(mHandler.ptr());
+        }
+    }
+
+    py::function mHandler;
+    std::mutex mMutex;
+    std::vector<std::pair<LogLevel, std::string>> mPending;
+};
+
+static std::shared_ptr<PythonLogSink> python_log_sink;
+
+// Install a Python log handler, or silence logging with handler=None
+static void set_log_handler(py::object handler, int level) {
+    if (handler.is_none())
+        python_log_sink.reset();
+    else
+        python_log_sink = std::make_shared<PythonLogSink>(handler.cast<py::function>());
+    set_log_sink(python_log_sink, (LogLevel) level);
 }
 
-// Python-friendly wrapper for batch_process
-std::tuple<py::array_t<float>, py::array_t<int>>
-remesh(py::array_t<float> vertices,
-       py::array_t<int> faces,
-       int target_vertex_count = -1,
-       int target_face_count = -1,
-       float target_edge_length = -1.0f,
-       int rosy = 4,
-       int posy = 4,
-       float crease_angle = -1.0f,
-       bool extrinsic = false,
-       bool align_to_boundaries = false,
-       int smooth_iterations = 2,
-       int knn_points = 10,
-       bool pure_quad = false,
-       bool deterministic = false) {
-    
+// Deliver records that were queued while a job ran
+static void flush_log() {
+    if (python_log_sink)
+        python_log_sink->flush();
+}
+
+/* Process-wide limit on the number of threads that run TBB work, including
+   the calling thread and the Optimizer thread. Every backend module links
+   its own copy of TBB, so each one holds its own limit */
+static std::unique_ptr<tbb::global_control> thread_limit;
+
+static void set_num_threads(int count) {
+    thread_limit.reset();
+    if (count > 0)
+        thread_limit.reset(new tbb::global_control(
+            tbb::global_control::max_allowed_parallelism, (size_t) count));
+}
+
+static int get_num_threads() {
+    if (!thread_limit)
+        return tbb::task_scheduler_init::default_num_threads();
+    return (int) tbb::global_control::active_value(
+        tbb::global_control::max_allowed_parallelism);
+}
+
+// Stop tracing and convert the events into Chrome trace event dictionaries
+static py::list stop_trace() {
+    const uint64_t origin = trace_origin();
+    py::list result;
+    for (const TraceThreadEvents &thread : trace_stop()) {
+        for (const TraceEvent &event : thread.events) {
+            py::dict entry;
+            entry["name"] = event.name;
+            entry["ph"] = "X";
+            entry["ts"] = (double) (int64_t) (event.begin - origin) * 1e-3;
+            entry["dur"] = (double) (event.end - event.begin) * 1e-3;
+            entry["tid"] = thread.thread;
+            if (event.arg >= 0) {
+                py::dict args;
+                args["level"] = event.arg;
+                entry["args"] = args;
+            }
+            result.append(entry);
+        }
+    }
+    return result;
+}
+
+// Collect the keyword arguments shared by remesh() and remesh_file()
+static RemeshOptions make_options(int target_vertex_count, int target_face_count,
+                                  Float target_edge_length, int rosy, int posy,
+                                  Float crease_angle, bool extrinsic,
+                                  bool align_to_boundaries, int smooth_iterations,
+                                  int knn_points, bool pure_quad, bool deterministic,
+                                  bool parallel_subdivide,
+                                  const std::string &vertex_ordering,
+                                  bool color_contiguous, Float solver_tolerance,
+                                  int solver_max_iterations, bool numa_interleave,
+                                  bool huge_pages, bool parallel_normals,
+                                  bool radix_downsample, bool direct_solver,
+                                  bool perf_counters) {
+    if (solver_max_iterations < 1)
+        throw std::invalid_argument("solver_max_iterations must be at least 1");
+    RemeshOptions opts;
+    opts.rosy = rosy;
+    opts.posy = posy;
+    opts.scale = target_edge_length;
+    opts.face_count = target_face_count;
+    opts.vertex_count = target_vertex_count;
+    opts.crease_angle = crease_angle;
+    opts.extrinsic = extrinsic;
+    opts.align_to_boundaries = align_to_boundaries;
+    opts.smooth_iterations = smooth_iterations;
+    opts.knn_points = knn_points;
+    opts.pure_quad = pure_quad;
+    opts.deterministic = deterministic;
+    opts.parallel_subdivide = parallel_subdivide;
+    opts.vertex_ordering = parse_vertex_ordering(vertex_ordering);
+    opts.color_contiguous = color_contiguous;
+    opts.solver_tolerance = solver_tolerance;
+    opts.solver_max_iterations = solver_max_iterations;
+    opts.numa_interleave = numa_interleave;
+    opts.huge_pages = huge_pages;
+    opts.parallel_normals = parallel_normals;
+    opts.radix_downsample = radix_downsample;
+    opts.direct_solver = direct_solver;
+    opts.perf_counters = perf_counters;
+    return opts;
+}
+
+// Convert the solver traces of a job into a Python dictionary
+static py::dict make_stats_dict(const RemeshStats &stats) {
+    auto convert = [](const SolverTrace &trace) {
+        py::list energy, iterations;
+        for (const auto &level : trace.energy) {
+            energy.append(py::cast(level));
+            iterations.append(level.size());
+        }
+        py::dict result;
+        result["energy"] = energy;
+        result["iterations"] = iterations;
+        return result;
+    };
+    py::dict result;
+    result["orientation"] = convert(stats.orientation);
+    result["position"] = convert(stats.position);
+    result["huge_pages"] = stats.huge_pages;
+    if (!stats.perf.empty()) {
+        py::dict perf;
+        for (const PerfStageCounts &stage : stats.perf) {
+            py::dict counters;
+            for (int k = 0; k < PerfCounterCount; ++k)
+                if (stage.available[k])
+                    counters[perf_counter_name(k)] = stage.value[k];
+            perf[stage.stage.c_str()] = counters;
+        }
+        result["perf"] = perf;
+    }
+    return result;
+}
+
+/* Package the extracted mesh and, if requested, the job statistics. The
+   returned arrays share the buffers of 'mesh' where the layout allows it */
+static py::tuple make_result(std::shared_ptr<RemeshOutput> mesh, const RemeshStats &stats,
+                             bool return_stats, FaceFormat format) {
+    RemeshOutput *data = mesh.get();
+    py::capsule owner(new std::shared_ptr<RemeshOutput>(std::move(mesh)), [](void *p) {
+        delete static_cast<std::shared_ptr<RemeshOutput> *>(p);
+    });
+    py::object vertices, faces;
+    if (format == FaceFormat::Triangles) {
+        py::tuple triangles = triangulate_compact(*data);
+        vertices = triangles[0];
+        faces = triangles[1];
+    } else {
+        vertices = share_columns<Float>(data->V, owner);
+        faces = convert_faces(data->F, format, owner);
+    }
+    if (return_stats)
+        return py::make_tuple(vertices, faces, make_stats_dict(stats));
+    return py::make_tuple(vertices, faces);
+}
+
+/* Pending write of an output file on a background thread. The thread keeps
+   the mesh it writes alive until the file is complete */
+class WriteHandle {
+public:
+    WriteHandle(const std::string &path, std::shared_future<void> future)
+        : mPath(path), mFuture(std::move(future)) { }
+
+    static WriteHandle start(const std::string &path,
+                             std::shared_ptr<const RemeshOutput> mesh) {
+        return WriteHandle(path, std::async(std::launch::async, [path, mesh]() {
+            write_output(path, mesh->F, mesh->V, mesh->Nf);
+        }).share());
+    }
+
+    const std::string &path() const { return mPath; }
+
+    bool done() const {
+        return mFuture.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+    }
+
+    /* Wait for the write to finish, at most 'timeout' seconds unless None.
+       Returns false on timeout, and rethrows errors of the write */
+    bool wait(py::object timeout) {
+        {
+            bool forever = timeout.is_none();
+            double seconds = forever ? 0.0 : timeout.cast<double>();
+            py::gil_scoped_release release;
+            if (forever)
+                mFuture.wait();
+            else if (mFuture.wait_for(std::chrono::duration<double>(seconds)) !=
+                     std::future_status::ready)
+                return false;
+        }
+        mFuture.get();
+        return true;
+    }
+
+private:
+    std::string mPath;
+    std::shared_future<void> mFuture;
+};
+
+// Load numpy vertex and face arrays into a RemeshInput
+static std::shared_ptr<RemeshInput> load_arrays(py::array_t<Float> vertices,
+                                                py::array_t<int> faces) {
     // Validate input
     py::buffer_info v_info = vertices.request();
     py::buffer_info f_info = faces.request();
@@ -170,55 +473,564 @@ remesh(py::array_t<float> vertices,
         throw std::runtime_error("Faces must be a Nx3 or Nx4 array");
     }
     
-    // Create temporary files with RAII cleanup
+    // Create a temporary input file with RAII cleanup
     TempFile input_file(generate_temp_filename("pyim_input", ".obj"));
-    TempFile output_file(generate_temp_filename("pyim_output", ".obj"));
     
-    // Write input mesh
-    write_temp_mesh(input_file.path, vertices, faces);
+    // Write input mesh and read it back through the loaders of instant-meshes
+    {
+        PYIM_TRACE_SCOPE("write_input");
+        write_temp_mesh(input_file.path, vertices, faces);
+    }
+    auto input = std::make_shared<RemeshInput>();
+    load_remesh_input(input_file.path, *input);
+    flush_log();
     
-    // Call batch_process
-    batch_process(input_file.path, output_file.path,
-                 rosy, posy, target_edge_length, 
-                 target_face_count, target_vertex_count,
-                 crease_angle, extrinsic, align_to_boundaries,
-                 smooth_iterations, knn_points, pure_quad, deterministic);
+    // The input file is auto-cleaned by the TempFile destructor
+    return input;
+}
+
+// Remesh a prepared input; shared by remesh() and Mesh.remesh()
+py::tuple
+remesh_input(const RemeshInput &input,
+       int target_vertex_count = -1,
+       int target_face_count = -1,
+       Float target_edge_length = -1.0f,
+       int rosy = 4,
+       int posy = 4,
+       Float crease_angle = -1.0f,
+       bool extrinsic = false,
+       bool align_to_boundaries = false,
+       int smooth_iterations = 2,
+       int knn_points = 10,
+       bool pure_quad = false,
+       bool deterministic = false,
+       bool parallel_subdivide = false,
+       const std::string& vertex_ordering = "none",
+       bool color_contiguous = false,
+       Float solver_tolerance = 0.0f,
+       int solver_max_iterations = 6,
+       bool return_stats = false,
+       bool numa_interleave = false,
+       bool huge_pages = false,
+       const std::string& face_format = "triangles",
+       bool parallel_normals = false,
+       bool radix_downsample = false,
+       bool direct_solver = false,
+       bool perf_counters = false,
+       SolverControl *solver_control = nullptr) {
+    FaceFormat format = parse_face_format(face_format);
+    RemeshOptions opts = make_options(target_vertex_count, target_face_count,
+                                      target_edge_length, rosy, posy, crease_angle,
+                                      extrinsic, align_to_boundaries, smooth_iterations,
+                                      knn_points, pure_quad, deterministic,
+                                      parallel_subdivide, vertex_ordering,
+                                      color_contiguous, solver_tolerance,
+                                      solver_max_iterations, numa_interleave,
+                                      huge_pages, parallel_normals,
+                                      radix_downsample, direct_solver,
+                                      perf_counters);
+    opts.solver_control = solver_control;
     
-    // Read output mesh (files will be auto-cleaned by TempFile destructors)
-    return read_temp_mesh(output_file.path);
+    // Run the batch stages, keeping the result in memory
+    RemeshStats stats;
+    std::unique_ptr<RemeshOutput> mesh(new RemeshOutput());
+    if (solver_control) {
+        /* Other Python threads may cancel the job meanwhile; its log records
+           are queued until flush_log() */
+        py::gil_scoped_release release;
+        remesh_pipeline(input, std::string(), opts, stats, mesh.get());
+    } else {
+        remesh_pipeline(input, std::string(), opts, stats, mesh.get());
+    }
+    flush_log();
+    
+    return make_result(std::move(mesh), stats, return_stats, format);
+}
+
+// Python-friendly wrapper for remesh_pipeline
+py::tuple
+remesh(py::array_t<Float> vertices,
+       py::array_t<int> faces,
+       int target_vertex_count = -1,
+       int target_face_count = -1,
+       Float target_edge_length = -1.0f,
+       int rosy = 4,
+       int posy = 4,
+       Float crease_angle = -1.0f,
+       bool extrinsic = false,
+       bool align_to_boundaries = false,
+       int smooth_iterations = 2,
+       int knn_points = 10,
+       bool pure_quad = false,
+       bool deterministic = false,
+       bool parallel_subdivide = false,
+       const std::string& vertex_ordering = "none",
+       bool color_contiguous = false,
+       Float solver_tolerance = 0.0f,
+       int solver_max_iterations = 6,
+       bool return_stats = false,
+       bool numa_interleave = false,
+       bool huge_pages = false,
+       const std::string& face_format = "triangles",
+       bool parallel_normals = false,
+       bool radix_downsample = false,
+       bool direct_solver = false,
+       bool perf_counters = false,
+       SolverControl *solver_control = nullptr) {
+    parse_face_format(face_format);
+    std::shared_ptr<RemeshInput> input = load_arrays(vertices, faces);
+    return remesh_input(*input, target_vertex_count, target_face_count,
+                        target_edge_length, rosy, posy, crease_angle, extrinsic,
+                        align_to_boundaries, smooth_iterations, knn_points,
+                        pure_quad, deterministic, parallel_subdivide,
+                        vertex_ordering, color_contiguous, solver_tolerance,
+                        solver_max_iterations, return_stats, numa_interleave,
+                        huge_pages, face_format, parallel_normals,
+                        radix_downsample, direct_solver,
+                        perf_counters, solver_control);
+}
+
+// Load a mesh from numpy arrays and compute its cached statistics
+static std::shared_ptr<RemeshInput> prepare_mesh(py::array_t<Float> vertices,
+                                                 py::array_t<int> faces) {
+    std::shared_ptr<RemeshInput> input = load_arrays(vertices, faces);
+    prepare_remesh_input(*input);
+    flush_log();
+    return input;
+}
+
+// Load a mesh file and compute its cached statistics
+static std::shared_ptr<RemeshInput> prepare_mesh_file(const std::string &path) {
+    auto input = std::make_shared<RemeshInput>();
+    load_remesh_input(path, *input);
+    prepare_remesh_input(*input);
+    flush_log();
+    return input;
+}
+
+/* Options of one sweep job from a dict of remesh() keyword arguments. Keys
+   that are not options of a single job (e.g. face_format) raise TypeError */
+static RemeshOptions options_from_dict(const py::dict &kwargs) {
+    RemeshOptions opts;
+    for (auto item : kwargs) {
+        const std::string key = item.first.cast<std::string>();
+        py::handle value = item.second;
+        if (key == "target_vertex_count")
+            opts.vertex_count = value.cast<int>();
+        else if (key == "target_face_count")
+            opts.face_count = value.cast<int>();
+        else if (key == "target_edge_length")
+            opts.scale = value.cast<Float>();
+        else if (key == "rosy")
+            opts.rosy = value.cast<int>();
+        else if (key == "posy")
+            opts.posy = value.cast<int>();
+        else if (key == "crease_angle")
+            opts.crease_angle = value.cast<Float>();
+        else if (key == "extrinsic")
+            opts.extrinsic = value.cast<bool>();
+        else if (key == "align_to_boundaries")
+            opts.align_to_boundaries = value.cast<bool>();
+        else if (key == "smooth_iterations")
+            opts.smooth_iterations = value.cast<int>();
+        else if (key == "knn_points")
+            opts.knn_points = value.cast<int>();
+        else if (key == "pure_quad")
+            opts.pure_quad = value.cast<bool>();
+        else if (key == "deterministic")
+            opts.deterministic = value.cast<bool>();
+        else if (key == "parallel_subdivide")
+            opts.parallel_subdivide = value.cast<bool>();
+        else if (key == "vertex_ordering")
+            opts.vertex_ordering = parse_vertex_ordering(value.cast<std::string>());
+        else if (key == "color_contiguous")
+            opts.color_contiguous = value.cast<bool>();
+        else if (key == "solver_tolerance")
+            opts.solver_tolerance = value.cast<Float>();
+        else if (key == "solver_max_iterations")
+            opts.solver_max_iterations = value.cast<int>();
+        else if (key == "numa_interleave")
+            opts.numa_interleave = value.cast<bool>();
+        else if (key == "huge_pages")
+            opts.huge_pages = value.cast<bool>();
+        else if (key == "parallel_normals")
+            opts.parallel_normals = value.cast<bool>();
+        else if (key == "radix_downsample")
+            opts.radix_downsample = value.cast<bool>();
+        else if (key == "direct_solver")
+            opts.direct_solver = value.cast<bool>();
+        else
+            throw py::type_error("remesh_sweep(): unsupported parameter '" + key + "'");
+    }
+    if (opts.solver_max_iterations < 1)
+        throw std::invalid_argument("solver_max_iterations must be at least 1");
+    return opts;
+}
+
+// Run the jobs of a parameter sweep; shared by remesh_sweep() and Mesh.remesh_sweep()
+static py::list remesh_sweep_input(const RemeshInput &input, py::list jobs,
+                                   const std::string &face_format, bool return_stats) {
+    FaceFormat format = parse_face_format(face_format);
+    std::vector<SweepJob> sweep(jobs.size());
+    for (size_t j = 0; j < sweep.size(); ++j)
+        sweep[j].opts = options_from_dict(jobs[j].cast<py::dict>());
+
+    std::vector<double> group_seconds;
+    remesh_sweep_pipeline(input, sweep, group_seconds);
+    flush_log();
+
+    py::list result;
+    for (SweepJob &job : sweep) {
+        py::tuple arrays = make_result(std::make_shared<RemeshOutput>(std::move(job.mesh)),
+                                       job.stats, return_stats, format);
+        py::dict entry;
+        entry["vertices"] = arrays[0];
+        entry["faces"] = arrays[1];
+        if (return_stats)
+            entry["stats"] = arrays[2];
+        entry["group"] = job.group;
+        entry["seconds"] = job.seconds;
+        entry["preprocess_seconds"] = group_seconds[job.group];
+        result.append(entry);
+    }
+    return result;
+}
+
+// Load a mesh from numpy arrays and run a parameter sweep on it
+static py::list remesh_sweep(py::array_t<Float> vertices, py::array_t<int> faces,
+                             py::list jobs, const std::string &face_format,
+                             bool return_stats) {
+    parse_face_format(face_format);
+    std::shared_ptr<RemeshInput> input = load_arrays(vertices, faces);
+    return remesh_sweep_input(*input, jobs, face_format, return_stats);
+}
+
+// Statistics of a prepared mesh as a Python dictionary
+static py::dict mesh_stats_dict(const RemeshInput &input) {
+    py::dict result;
+    if (!input.hasStats)
+        return result;
+    const MeshStats &stats = input.stats;
+    result["surface_area"] = (double) stats.mSurfaceArea;
+    result["average_edge_length"] = (double) stats.mAverageEdgeLength;
+    result["maximum_edge_length"] = (double) stats.mMaximumEdgeLength;
+    result["bbox_min"] = py::make_tuple(stats.mAABB.min.x(), stats.mAABB.min.y(),
+                                        stats.mAABB.min.z());
+    result["bbox_max"] = py::make_tuple(stats.mAABB.max.x(), stats.mAABB.max.y(),
+                                        stats.mAABB.max.z());
+    return result;
 }
 
 // Python-friendly wrapper for remeshing from file
-std::tuple<py::array_t<float>, py::array_t<int>>
+py::object
 remesh_file(const std::string& input_path,
            const std::string& output_path,
            int target_vertex_count = -1,
            int target_face_count = -1,
-           float target_edge_length = -1.0f,
+           Float target_edge_length = -1.0f,
            int rosy = 4,
            int posy = 4,
-           float crease_angle = -1.0f,
+           Float crease_angle = -1.0f,
            bool extrinsic = false,
            bool align_to_boundaries = false,
            int smooth_iterations = 2,
            int knn_points = 10,
            bool pure_quad = false,
-           bool deterministic = false) {
+           bool deterministic = false,
+           bool parallel_subdivide = false,
+           const std::string& vertex_ordering = "none",
+           bool color_contiguous = false,
+           Float solver_tolerance = 0.0f,
+           int solver_max_iterations = 6,
+           bool return_stats = false,
+           bool numa_interleave = false,
+           bool huge_pages = false,
+           const std::string& face_format = "triangles",
+           bool return_arrays = true,
+           bool background_write = false,
+           bool parallel_normals = false,
+           bool radix_downsample = false,
+           bool direct_solver = false,
+           bool perf_counters = false) {
+    FaceFormat format = parse_face_format(face_format);
+    
+    /* Only OBJ files can be written in the background: write_mesh() reports
+       its progress on std::cout, which is redirected only while a job runs */
+    if (background_write && !has_obj_extension(output_path))
+        throw std::invalid_argument("background_write requires an .obj output_path");
     
-    // Call batch_process
-    batch_process(input_path, output_path,
-                 rosy, posy, target_edge_length, 
-                 target_face_count, target_vertex_count,
-                 crease_angle, extrinsic, align_to_boundaries,
-                 smooth_iterations, knn_points, pure_quad, deterministic);
+    // Run the batch stages; the mesh is only kept if it is still needed
+    RemeshStats stats;
+    std::shared_ptr<RemeshOutput> mesh;
+    if (return_arrays || background_write)
+        mesh = std::make_shared<RemeshOutput>();
+    remesh_pipeline(input_path, background_write ? std::string() : output_path,
+                    make_options(target_vertex_count, target_face_count,
+                                 target_edge_length, rosy, posy, crease_angle,
+                                 extrinsic, align_to_boundaries, smooth_iterations,
+                                 knn_points, pure_quad, deterministic,
+                                 parallel_subdivide, vertex_ordering,
+                                 color_contiguous, solver_tolerance,
+                                 solver_max_iterations, numa_interleave,
+                                 huge_pages, parallel_normals,
+                                 radix_downsample, direct_solver,
+                                 perf_counters),
+                    stats, mesh.get());
+    flush_log();
     
-    // Read output mesh
-    return read_temp_mesh(output_path);
+    /* The 'quads' and 'csr' arrays share the buffers of the mesh and may be
+       modified while the file is written, so the writer gets its own copy */
+    py::object handle = py::none();
+    if (background_write) {
+        std::shared_ptr<RemeshOutput> written = mesh;
+        if (return_arrays && format != FaceFormat::Triangles) {
+            written = std::make_shared<RemeshOutput>();
+            written->F = mesh->F;
+            written->V = mesh->V;
+        }
+        handle = py::cast(WriteHandle::start(output_path, std::move(written)));
+    }
+    
+    // Return the mesh that was written to output_path, followed by the handle
+    py::list result;
+    if (return_arrays)
+        result = py::list(make_result(std::move(mesh), stats, return_stats, format));
+    else if (return_stats)
+        result.append(make_stats_dict(stats));
+    if (background_write)
+        result.append(handle);
+    if (!return_arrays && result.size() <= 1)
+        return result.size() == 1 ? py::object(result[0]) : py::none();
+    return py::tuple(result);
 }
 
-PYBIND11_MODULE(_pyinstantmeshes, m) {
+/* The double precision backend compiles this file a second time against a
+   copy of the instant-meshes sources without SINGLE_PRECISION */
+#ifndef PYIM_MODULE_NAME
+#define PYIM_MODULE_NAME _pyinstantmeshes
+#endif
+
+PYBIND11_MODULE(PYIM_MODULE_NAME, m) {
     m.doc() = "Python bindings for Instant Meshes - fast automatic retopology";
     
+    py::module testing = m.def_submodule("_testing", "Kernel entry points for the test suite");
+    register_testing(testing);
+    
+    /* Both backend modules bind the same C++ classes, so the bindings are
+       local to each module rather than registered process-wide */
+    py::class_<WriteHandle>(m, "WriteHandle",
+                            "Pending write of an output file of remesh_file()",
+                            py::module_local())
+        .def_property_readonly("path", &WriteHandle::path,
+                               "Path of the output file")
+        .def("done", &WriteHandle::done,
+             "Return True if the file has been written (or the write failed)")
+        .def("wait", &WriteHandle::wait, py::arg("timeout") = py::none(),
+             "Wait for the write to finish, at most timeout seconds. Returns\n"
+             "False on timeout and raises if the write failed");
+    
+    py::class_<SolverControl>(m, "SolverControl",
+                              "Cancellation and progress of the solver of a running\n"
+                              "remesh(..., solver_control=...) job", py::module_local())
+        .def(py::init<>())
+        .def("cancel", [](SolverControl &control) { control.cancel.store(true); },
+             "Ask the job to stop before its next solver sweep")
+        .def_property_readonly("cancelled",
+                               [](const SolverControl &control) { return control.cancel.load(); },
+                               "True once cancel() was called")
+        .def_property_readonly("sweeps",
+                               [](const SolverControl &control) { return control.sweeps.load(); },
+                               "Number of solver sweeps completed so far, over all levels\n"
+                               "and both fields");
+    
+    py::class_<RemeshInput, std::shared_ptr<RemeshInput>>(m, "Mesh",
+        "Input mesh with cached statistics, see prepare_mesh()", py::module_local())
+        .def_property_readonly("vertex_count",
+                               [](const RemeshInput &input) { return (size_t) input.V.cols(); },
+                               "Number of input vertices")
+        .def_property_readonly("face_count",
+                               [](const RemeshInput &input) { return (size_t) input.F.cols(); },
+                               "Number of input faces")
+        .def_property_readonly("stats", &mesh_stats_dict,
+                               "Cached statistics: 'surface_area', 'average_edge_length',\n"
+                               "'maximum_edge_length', 'bbox_min' and 'bbox_max'")
+        .def("remesh", &remesh_input,
+             py::arg("target_vertex_count") = -1,
+             py::arg("target_face_count") = -1,
+             py::arg("target_edge_length") = -1.0f,
+             py::arg("rosy") = 4,
+             py::arg("posy") = 4,
+             py::arg("crease_angle") = -1.0f,
+             py::arg("extrinsic") = false,
+             py::arg("align_to_boundaries") = false,
+             py::arg("smooth_iterations") = 2,
+             py::arg("knn_points") = 10,
+             py::arg("pure_quad") = false,
+             py::arg("deterministic") = false,
+             py::arg("parallel_subdivide") = false,
+             py::arg("vertex_ordering") = "none",
+             py::arg("color_contiguous") = false,
+             py::arg("solver_tolerance") = 0.0f,
+             py::arg("solver_max_iterations") = 6,
+             py::arg("return_stats") = false,
+             py::arg("numa_interleave") = false,
+             py::arg("huge_pages") = false,
+             py::arg("face_format") = "triangles",
+             py::arg("parallel_normals") = false,
+             py::arg("radix_downsample") = false,
+             py::arg("direct_solver") = false,
+             py::arg("perf_counters") = false,
+             py::arg("solver_control") = py::none(),
+             "Remesh this mesh. Takes the same keyword arguments as remesh()\n"
+             "and returns the same values; the mesh itself is not modified")
+        .def("remesh_sweep", &remesh_sweep_input,
+             py::arg("jobs"),
+             py::arg("face_format") = "triangles",
+             py::arg("return_stats") = false,
+             "Run several jobs on this mesh concurrently, see remesh_sweep()");
+    
+    m.def("prepare_mesh", &prepare_mesh,
+          py::arg("vertices"),
+          py::arg("faces"),
+          R"pbdoc(
+        Load a mesh once for several remesh() calls.
+        
+        The mesh statistics and face areas are computed in a single pass
+        and cached, so that Mesh.remesh() calls with different targets
+        skip the pass.
+        
+        Parameters
+        ----------
+        vertices : numpy.ndarray
+            Input vertex positions as Nx3 float array
+        faces : numpy.ndarray
+            Input face indices as Nx3 or Nx4 int array
+        
+        Returns
+        -------
+        mesh : Mesh
+            Prepared mesh
+    )pbdoc");
+    
+    m.def("remesh_sweep", &remesh_sweep,
+          py::arg("vertices"),
+          py::arg("faces"),
+          py::arg("jobs"),
+          py::arg("face_format") = "triangles",
+          py::arg("return_stats") = false,
+          R"pbdoc(
+        Remesh a mesh with several parameter sets concurrently.
+        
+        Jobs that agree on the options the preprocessing depends on (crease
+        angle, subdivision, vertex ordering, hierarchy construction, ...)
+        share one adjacency, normal and hierarchy computation, and the
+        jobs then solve and extract in parallel on their own copies of the
+        fields. Jobs always use the solver schedule of direct_solver, and
+        their progress output is discarded.
+        
+        Parameters
+        ----------
+        vertices : numpy.ndarray
+            Input vertex positions as Nx3 float array
+        faces : numpy.ndarray
+            Input face indices as Nx3 or Nx4 int array
+        jobs : list of dict
+            remesh() keyword arguments of every job, except face_format,
+            return_stats and perf_counters
+        face_format : str, optional
+            Layout of the returned faces, see remesh() (default: 'triangles')
+        return_stats : bool, optional
+            Add the statistics of every job, see remesh() (default: False)
+        
+        Returns
+        -------
+        results : list of dict
+            One dict per job, in order, with 'vertices', 'faces', 'stats'
+            (with return_stats), 'group' (index of the shared
+            preprocessing), 'seconds' (solve and extraction of the job) and
+            'preprocess_seconds' (shared preprocessing of its group)
+    )pbdoc");
+    
+    m.def("prepare_mesh_file", &prepare_mesh_file,
+          py::arg("path"),
+          R"pbdoc(
+        Load a mesh file once for several remesh() calls, see prepare_mesh().
+        
+        Parameters
+        ----------
+        path : str
+            Path to input mesh file (OBJ, PLY, etc.)
+        
+        Returns
+        -------
+        mesh : Mesh
+            Prepared mesh
+    )pbdoc");
+    
+    m.def("set_log_handler", &set_log_handler,
+          py::arg("handler"),
+          py::arg("level") = (int) LogLevel::Info,
+          R"pbdoc(
+        Route the progress output of the remeshing stages to a callable.
+        
+        Parameters
+        ----------
+        handler : callable or None
+            Called as handler(level, message) for every record, where level
+            is a level number of the logging module. None silences all
+            output, which is the default
+        level : int, optional
+            Minimum level of the forwarded records (default: logging.INFO)
+    )pbdoc");
+    
+    m.def("set_num_threads", &set_num_threads,
+          py::arg("count"),
+          R"pbdoc(
+        Limit the number of threads that run the remeshing stages.
+        
+        Parameters
+        ----------
+        count : int
+            Maximum number of threads, including the calling thread. Zero or
+            a negative value removes the limit
+    )pbdoc");
+    
+    m.def("get_num_threads", &get_num_threads,
+          "Return the current thread limit, or the number of hardware threads");
+    
+    m.def("tracing_available", &trace_available,
+          "Return True if this module was built with tracing support");
+    
+    m.def("start_trace", [](size_t capacity) { trace_start(capacity); },
+          py::arg("capacity") = 65536,
+          R"pbdoc(
+        Start recording trace events of the remeshing stages.
+        
+        Parameters
+        ----------
+        capacity : int, optional
+            Number of events kept per thread; older events are overwritten
+            (default: 65536)
+    )pbdoc");
+    
+    m.def("stop_trace", &stop_trace,
+          R"pbdoc(
+        Stop recording and return the events since start_trace().
+        
+        Returns
+        -------
+        events : list of dict
+            Complete events in the Chrome trace event format ('name', 'ph',
+            'ts' and 'dur' in microseconds, 'tid', and 'args' with the
+            hierarchy level where applicable), without 'pid'
+    )pbdoc");
+    
+    // The handler must be released while the interpreter is still alive
+    py::module::import("atexit").attr("register")(py::cpp_function([]() {
+        set_log_sink(nullptr, LogLevel::Off);
+        python_log_sink.reset();
+    }));
+    
     m.def("remesh", &remesh,
           py::arg("vertices"),
           py::arg("faces"),
@@ -234,6 +1046,20 @@ PYBIND11_MODULE(_pyinstantmeshes, m) {
           py::arg("knn_points") = 10,
           py::arg("pure_quad") = false,
           py::arg("deterministic") = false,
+          py::arg("parallel_subdivide") = false,
+          py::arg("vertex_ordering") = "none",
+          py::arg("color_contiguous") = false,
+          py::arg("solver_tolerance") = 0.0f,
+          py::arg("solver_max_iterations") = 6,
+          py::arg("return_stats") = false,
+          py::arg("numa_interleave") = false,
+          py::arg("huge_pages") = false,
+          py::arg("face_format") = "triangles",
+          py::arg("parallel_normals") = false,
+          py::arg("radix_downsample") = false,
+          py::arg("direct_solver") = false,
+          py::arg("perf_counters") = false,
+          py::arg("solver_control") = py::none(),
           R"pbdoc(
         Remesh a triangular or quad mesh for better topology.
         
@@ -267,13 +1093,83 @@ PYBIND11_MODULE(_pyinstantmeshes, m) {
             Generate pure quad mesh (default: False)
         deterministic : bool, optional
             Use deterministic mode (default: False)
+        parallel_subdivide : bool, optional
+            Refine coarse inputs in parallel rounds instead of one edge at a
+            time (default: False)
+        vertex_ordering : str, optional
+            Renumber the input before building the hierarchy for better
+            memory locality: 'none', 'morton', 'hilbert' or 'rcm'
+            (default: 'none')
+        color_contiguous : bool, optional
+            Store the vertices of each graph coloring phase contiguously on
+            every hierarchy level (default: False)
+        solver_tolerance : float, optional
+            Stop the field sweeps on a hierarchy level once the relative
+            energy change drops below this value. If <= 0, every level runs
+            the fixed upstream schedule (default: 0.0)
+        solver_max_iterations : int, optional
+            Maximum number of sweeps per level when solver_tolerance > 0, and
+            number of sweeps per level with direct_solver (default: 6)
+        return_stats : bool, optional
+            Also return a dictionary with the per-level solver energies and
+            iteration counts (default: False)
+        numa_interleave : bool, optional
+            On multi-socket machines, spread the worker threads round-robin
+            over the NUMA nodes and re-allocate the hierarchy data with its
+            pages interleaved over the nodes before solving (default: False)
+        huge_pages : bool, optional
+            Re-allocate the hierarchy data in memory advised for transparent
+            2 MB huge pages before solving, which reduces TLB misses on large
+            meshes (Linux only, default: False)
+        face_format : str, optional
+            Layout of the returned faces: 'triangles' (Nx3, quads are
+            split, and vertices are numbered by first use with unreferenced
+            ones dropped, as when the output was read back from an OBJ
+            file), 'quads' (the extracted faces without triangulation, Nx4
+            for posy=4 with triangles repeating their last index, Nx3 for
+            posy=3) or 'csr' (an (offsets, indices) pair, where face i has
+            the corners indices[offsets[i]:offsets[i + 1]]) (default: 'triangles')
+        parallel_normals : bool, optional
+            Compute vertex and crease normals with gather-style parallel
+            passes over the directed edges. Crease vertices get the bisector
+            of the sector normals on both sides of the crease and are not
+            duplicated (default: False)
+        radix_downsample : bool, optional
+            Build the hierarchy with a radix sort of the collapse scores and
+            a parallel matching instead of a comparison sort and a serial
+            greedy pass. The matching is the same up to ties between scores
+            that only differ beyond single precision (default: False)
+        direct_solver : bool, optional
+            Run the fixed schedule of the field solver (solver_max_iterations
+            sweeps per level) as parallel loops on the calling thread instead
+            of handing it to the background thread of the Optimizer class.
+            Has no effect with solver_tolerance > 0 (default: False)
+        perf_counters : bool, optional
+            Count CPU cycles, instructions, last-level cache misses and dTLB
+            misses of every stage across all worker threads with Linux perf
+            events, and report them in stats['perf']. Counters that are not
+            available, e.g. inside containers, are left out (default: False)
+        solver_control : SolverControl, optional
+            Cancel the job or poll its progress from another Python thread.
+            The job then runs without the GIL, the solver runs as with
+            direct_solver, and its progress output is delivered when it
+            returns. Cancelling raises RuntimeError at the next sweep
+            (default: None)
         
         Returns
         -------
         vertices : numpy.ndarray
             Output vertex positions as Nx3 float array
-        faces : numpy.ndarray
-            Output face indices as Nx3 or Nx4 int array
+        faces : numpy.ndarray or tuple
+            Output face indices in the layout selected by face_format
+        stats : dict
+            Only if return_stats is True. 'orientation' and 'position' map
+            to dicts with 'energy' (list of per-sweep energies for every
+            level, finest first) and 'iterations' (sweeps per level); both
+            are empty unless solver_tolerance > 0. 'huge_pages' is the number
+            of huge pages that back the hierarchy data with huge_pages=True.
+            With perf_counters=True, 'perf' maps the name of every stage to
+            a dict of the available counters
     )pbdoc");
     
     m.def("remesh_file", &remesh_file,
@@ -291,6 +1187,21 @@ PYBIND11_MODULE(_pyinstantmeshes, m) {
           py::arg("knn_points") = 10,
           py::arg("pure_quad") = false,
           py::arg("deterministic") = false,
+          py::arg("parallel_subdivide") = false,
+          py::arg("vertex_ordering") = "none",
+          py::arg("color_contiguous") = false,
+          py::arg("solver_tolerance") = 0.0f,
+          py::arg("solver_max_iterations") = 6,
+          py::arg("return_stats") = false,
+          py::arg("numa_interleave") = false,
+          py::arg("huge_pages") = false,
+          py::arg("face_format") = "triangles",
+          py::arg("return_arrays") = true,
+          py::arg("background_write") = false,
+          py::arg("parallel_normals") = false,
+          py::arg("radix_downsample") = false,
+          py::arg("direct_solver") = false,
+          py::arg("perf_counters") = false,
           R"pbdoc(
         Remesh a mesh from an input file and save to an output file.
         
@@ -324,12 +1235,87 @@ PYBIND11_MODULE(_pyinstantmeshes, m) {
             Generate pure quad mesh (default: False)
         deterministic : bool, optional
             Use deterministic mode (default: False)
+        parallel_subdivide : bool, optional
+            Refine coarse inputs in parallel rounds instead of one edge at a
+            time (default: False)
+        vertex_ordering : str, optional
+            Renumber the input before building the hierarchy for better
+            memory locality: 'none', 'morton', 'hilbert' or 'rcm'
+            (default: 'none')
+        color_contiguous : bool, optional
+            Store the vertices of each graph coloring phase contiguously on
+            every hierarchy level (default: False)
+        solver_tolerance : float, optional
+            Stop the field sweeps on a hierarchy level once the relative
+            energy change drops below this value. If <= 0, every level runs
+            the fixed upstream schedule (default: 0.0)
+        solver_max_iterations : int, optional
+            Maximum number of sweeps per level when solver_tolerance > 0, and
+            number of sweeps per level with direct_solver (default: 6)
+        return_stats : bool, optional
+            Also return a dictionary with the per-level solver energies and
+            iteration counts (default: False)
+        numa_interleave : bool, optional
+            On multi-socket machines, spread the worker threads round-robin
+            over the NUMA nodes and re-allocate the hierarchy data with its
+            pages interleaved over the nodes before solving (default: False)
+        huge_pages : bool, optional
+            Re-allocate the hierarchy data in memory advised for transparent
+            2 MB huge pages before solving, which reduces TLB misses on large
+            meshes (Linux only, default: False)
+        face_format : str, optional
+            Layout of the returned faces: 'triangles' (Nx3, quads are
+            split, and vertices are numbered by first use with unreferenced
+            ones dropped, as when the output was read back from an OBJ
+            file), 'quads' (the extracted faces without triangulation, Nx4
+            for posy=4 with triangles repeating their last index, Nx3 for
+            posy=3) or 'csr' (an (offsets, indices) pair, where face i has
+            the corners indices[offsets[i]:offsets[i + 1]]) (default: 'triangles')
+        return_arrays : bool, optional
+            Return the remeshed vertices and faces. With False, the mesh is
+            only written to output_path and the function returns None, or
+            the stats dictionary if return_stats is True (default: True)
+        background_write : bool, optional
+            Return as soon as the mesh is extracted and write an .obj output
+            file on a background thread. A WriteHandle is appended to the
+            returned values; call its wait() before using the file. The
+            writer has its own copy of the mesh, so the returned arrays may
+            be modified right away. Raises ValueError if output_path is not
+            an .obj file (default: False)
+        parallel_normals : bool, optional
+            Compute vertex and crease normals with gather-style parallel
+            passes over the directed edges. Crease vertices get the bisector
+            of the sector normals on both sides of the crease and are not
+            duplicated (default: False)
+        radix_downsample : bool, optional
+            Build the hierarchy with a radix sort of the collapse scores and
+            a parallel matching instead of a comparison sort and a serial
+            greedy pass. The matching is the same up to ties between scores
+            that only differ beyond single precision (default: False)
+        direct_solver : bool, optional
+            Run the fixed schedule of the field solver (solver_max_iterations
+            sweeps per level) as parallel loops on the calling thread instead
+            of handing it to the background thread of the Optimizer class.
+            Has no effect with solver_tolerance > 0 (default: False)
+        perf_counters : bool, optional
+            Count CPU cycles, instructions, last-level cache misses and dTLB
+            misses of every stage across all worker threads with Linux perf
+            events, and report them in stats['perf']. Counters that are not
+            available, e.g. inside containers, are left out (default: False)
         
         Returns
         -------
         vertices : numpy.ndarray
             Output vertex positions as Nx3 float array
-        faces : numpy.ndarray
-            Output face indices as Nx3 or Nx4 int array
+        faces : numpy.ndarray or tuple
+            Output face indices in the layout selected by face_format
+        stats : dict
+            Only if return_stats is True. 'orientation' and 'position' map
+            to dicts with 'energy' (list of per-sweep energies for every
+            level, finest first) and 'iterations' (sweeps per level); both
+            are empty unless solver_tolerance > 0. 'huge_pages' is the number
+            of huge pages that back the hierarchy data with huge_pages=True.
+            With perf_counters=True, 'perf' maps the name of every stage to
+            a dict of the available counters
     )pbdoc");
 }
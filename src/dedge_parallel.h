@@ -0,0 +1,28 @@
+/*
+    dedge_parallel.h -- Sort-based parallel directed edge construction
+
+    Drop-in replacement for build_dedge() from the instant-meshes submodule.
+    Half-edges are sorted by their undirected vertex pair, so opposite edges
+    and non-manifold fans can be detected group by group without walking
+    shared linked lists.
+
+    There is no counterpart of remove_nonmanifold(): batch_process() does not
+    call it, and the pipeline keeps flagging non-manifold vertices and
+    leaving them out of the adjacency, as upstream does.
+*/
+
+#pragma once
+
+#include "arena.h"
+
+/**
+ * Compute the directed edge data structure of a triangle or quad mesh.
+ *
+ * Produces the same V2E, E2E, boundary and nonManifold arrays as the serial
+ * traversal order of build_dedge(), independently of the number of threads.
+ * Temporaries are allocated from 'arena' if given.
+ */
+extern void build_dedge_parallel(const MatrixXu &F, const MatrixXf &V,
+                                 VectorXu &V2E, VectorXu &E2E,
+                                 VectorXb &boundary, VectorXb &nonManifold,
+                                 JobArena *arena = nullptr);
@@ -0,0 +1,40 @@
+/*
+    face_block.h -- Structure-of-arrays blocks of face corners
+
+    Kernels that visit every face gather the corners of a range of faces
+    into arrays with one contiguous column per coordinate. Edge vectors,
+    cross products and norms of the whole block are then evaluated by
+    Eigen's vectorized array expressions instead of one face at a time.
+*/
+
+#pragma once
+
+#include "common.h"
+
+// A block of 3D points or vectors, one row per face
+typedef Eigen::Array<Float, Eigen::Dynamic, 3> PointBlock;
+typedef Eigen::Array<Float, Eigen::Dynamic, 1> ScalarBlock;
+
+// Gather corner k of the triangles [begin, end) into p[k]
+inline void gather_corners(const MatrixXu &F, const MatrixXf &V,
+                           uint32_t begin, uint32_t end, PointBlock p[3]) {
+    const uint32_t n = end - begin;
+    for (int k = 0; k < 3; ++k)
+        p[k].resize(n, 3);
+    for (uint32_t j = 0; j < n; ++j)
+        for (int k = 0; k < 3; ++k)
+            p[k].row(j) = V.col(F(k, begin + j)).transpose().array();
+}
+
+// Row-wise dot product
+inline ScalarBlock block_dot(const PointBlock &a, const PointBlock &b) {
+    return a.col(0) * b.col(0) + a.col(1) * b.col(1) + a.col(2) * b.col(2);
+}
+
+// Row-wise cross product
+inline void block_cross(const PointBlock &a, const PointBlock &b, PointBlock &result) {
+    result.resize(a.rows(), 3);
+    result.col(0) = a.col(1) * b.col(2) - a.col(2) * b.col(1);
+    result.col(1) = a.col(2) * b.col(0) - a.col(0) * b.col(2);
+    result.col(2) = a.col(0) * b.col(1) - a.col(1) * b.col(0);
+}
@@ -0,0 +1,38 @@
+/*
+    hierarchy_access.h -- Access to the level arrays of MultiResolutionHierarchy
+
+    The level arrays of MultiResolutionHierarchy are protected members
+    without setters for coarse levels. A pointer to a protected member
+    formed inside a derived class may be applied to any object of the base
+    class, which gives access to them without patching the submodule.
+*/
+
+#pragma once
+
+#include "hierarchy.h"
+
+struct HierarchyAccess : MultiResolutionHierarchy {
+    template <typename T>
+    static T &get(MultiResolutionHierarchy &mRes, T MultiResolutionHierarchy::*member) {
+        return mRes.*member;
+    }
+
+    static std::vector<AdjacencyMatrix> &adj(MultiResolutionHierarchy &h) { return get(h, &HierarchyAccess::mAdj); }
+    static std::vector<MatrixXf> &V(MultiResolutionHierarchy &h) { return get(h, &HierarchyAccess::mV); }
+    static std::vector<MatrixXf> &N(MultiResolutionHierarchy &h) { return get(h, &HierarchyAccess::mN); }
+    static std::vector<VectorXf> &A(MultiResolutionHierarchy &h) { return get(h, &HierarchyAccess::mA); }
+    static std::vector<MatrixXf> &Q(MultiResolutionHierarchy &h) { return get(h, &HierarchyAccess::mQ); }
+    static std::vector<MatrixXf> &O(MultiResolutionHierarchy &h) { return get(h, &HierarchyAccess::mO); }
+    static std::vector<MatrixXf> &CQ(MultiResolutionHierarchy &h) { return get(h, &HierarchyAccess::mCQ); }
+    static std::vector<MatrixXf> &CO(MultiResolutionHierarchy &h) { return get(h, &HierarchyAccess::mCO); }
+    static std::vector<VectorXf> &CQw(MultiResolutionHierarchy &h) { return get(h, &HierarchyAccess::mCQw); }
+    static std::vector<VectorXf> &COw(MultiResolutionHierarchy &h) { return get(h, &HierarchyAccess::mCOw); }
+    static std::vector<MatrixXu> &toUpper(MultiResolutionHierarchy &h) { return get(h, &HierarchyAccess::mToUpper); }
+    static std::vector<VectorXu> &toLower(MultiResolutionHierarchy &h) { return get(h, &HierarchyAccess::mToLower); }
+    static std::vector<std::vector<std::vector<uint32_t>>> &phases(MultiResolutionHierarchy &h) {
+        return get(h, &HierarchyAccess::mPhases);
+    }
+    static auto totalSize(MultiResolutionHierarchy &h) -> decltype(get(h, &HierarchyAccess::mTotalSize)) {
+        return get(h, &HierarchyAccess::mTotalSize);
+    }
+};
@@ -0,0 +1,176 @@
+/*
+    hierarchy_layout.cpp -- Color-contiguous memory layout for the solver phases
+
+    MultiResolutionHierarchy only hands out read-only references to the
+    phases and to the maps between levels. These are non-const members of
+    the (non-const) hierarchy, so writing through them after a const_cast is
+    well-defined; it is the only way to update them without patching the
+    instant-meshes submodule.
+*/
+
+#include "hierarchy_layout.h"
+#include "trace.h"
+
+#include <algorithm>
+
+namespace {
+
+// Reorder the columns of a per-vertex matrix ('order' maps new to old indices)
+template <typename Matrix>
+void permute_columns(Matrix &M, const ArenaVector<uint32_t> &order) {
+    if ((size_t) M.cols() != order.size())
+        return;
+    Matrix result(M.rows(), M.cols());
+    tbb::parallel_for(
+        tbb::blocked_range<uint32_t>(0u, (uint32_t) order.size(), GRAIN_SIZE),
+        [&](const tbb::blocked_range<uint32_t> &range) {
+            for (uint32_t i = range.begin(); i != range.end(); ++i)
+                result.col(i) = M.col(order[i]);
+        }
+    );
+    M = std::move(result);
+}
+
+// Reorder the entries of a per-vertex vector
+template <typename Vector>
+void permute_entries(Vector &v, const ArenaVector<uint32_t> &order) {
+    if ((size_t) v.size() != order.size())
+        return;
+    Vector result(v.size());
+    tbb::parallel_for(
+        tbb::blocked_range<uint32_t>(0u, (uint32_t) order.size(), GRAIN_SIZE),
+        [&](const tbb::blocked_range<uint32_t> &range) {
+            for (uint32_t i = range.begin(); i != range.end(); ++i)
+                result[i] = v[order[i]];
+        }
+    );
+    v = std::move(result);
+}
+
+// Replace vertex indices stored in a matrix by their new values
+template <typename Matrix>
+void remap_indices(Matrix &M, const ArenaVector<uint32_t> &rank) {
+    uint32_t *data = M.data();
+    tbb::parallel_for(
+        tbb::blocked_range<size_t>(0u, (size_t) M.size(), GRAIN_SIZE),
+        [&](const tbb::blocked_range<size_t> &range) {
+            for (size_t i = range.begin(); i != range.end(); ++i)
+                if (data[i] != INVALID)
+                    data[i] = rank[data[i]];
+        }
+    );
+}
+
+/* Reorder the rows of an adjacency matrix in place. Rows are stored back to
+   back in a single block starting at adj[0] (row i ends where row i+1
+   begins), so the block and the row pointer array can be reused as is */
+void permute_adjacency(AdjacencyMatrix adj, const ArenaVector<uint32_t> &order,
+                       const ArenaVector<uint32_t> &rank, Arena *arena) {
+    const uint32_t n = (uint32_t) order.size();
+    Link *base = adj[0];
+    ArenaScope scope(arena);
+    ArenaVector<Link> links(adj[0], adj[n], ArenaAllocator<Link>(arena));
+    ArenaVector<size_t> oldOffset(n + 1, 0, ArenaAllocator<size_t>(arena)),
+                        newOffset(n + 1, 0, ArenaAllocator<size_t>(arena));
+    for (uint32_t i = 0; i <= n; ++i)
+        oldOffset[i] = adj[i] - base;
+    for (uint32_t i = 0; i < n; ++i)
+        newOffset[i + 1] = newOffset[i] + (oldOffset[order[i] + 1] - oldOffset[order[i]]);
+
+    tbb::parallel_for(
+        tbb::blocked_range<uint32_t>(0u, n, GRAIN_SIZE),
+        [&](const tbb::blocked_range<uint32_t> &range) {
+            for (uint32_t i = range.begin(); i != range.end(); ++i) {
+                const Link *src = links.data() + oldOffset[order[i]];
+                Link *dst = base + newOffset[i];
+                size_t count = oldOffset[order[i] + 1] - oldOffset[order[i]];
+                for (size_t j = 0; j < count; ++j) {
+                    dst[j] = src[j];
+                    dst[j].id = rank[src[j].id];
+                }
+            }
+        }
+    );
+
+    for (uint32_t i = 0; i <= n; ++i)
+        adj[i] = base + newOffset[i];
+}
+
+} // namespace
+
+void make_phases_contiguous(MultiResolutionHierarchy &mRes,
+                            std::set<uint32_t> &creases, JobArena *arena) {
+    PYIM_TRACE_SCOPE("make_phases_contiguous");
+    cout << "Laying out color classes contiguously .. ";
+    cout.flush();
+    Timer<> timer;
+
+    const int levels = mRes.levels();
+    Arena *scratch = arena ? &arena->shared() : nullptr;
+    ArenaScope scope(scratch);
+    ArenaAllocator<uint32_t> alloc(scratch);
+    std::vector<ArenaVector<uint32_t>> order(levels, ArenaVector<uint32_t>(alloc)),
+                                       rank(levels, ArenaVector<uint32_t>(alloc));
+
+    /* New order of every level: phase by phase, ascending within a phase */
+    for (int l = 0; l < levels; ++l) {
+        const uint32_t n = mRes.size(l);
+        auto &phases = const_cast<std::vector<std::vector<uint32_t>> &>(mRes.phases(l));
+        std::vector<bool> placed(n, false);
+        order[l].reserve(n);
+        for (auto &phase : phases) {
+            std::sort(phase.begin(), phase.end());
+            for (uint32_t i : phase) {
+                order[l].push_back(i);
+                placed[i] = true;
+            }
+        }
+        for (uint32_t i = 0; i < n; ++i)
+            if (!placed[i])
+                order[l].push_back(i);
+
+        rank[l].resize(n);
+        for (uint32_t i = 0; i < n; ++i)
+            rank[l][order[l][i]] = i;
+
+        /* The phases are now consecutive ranges */
+        uint32_t next = 0;
+        for (auto &phase : phases)
+            for (uint32_t &i : phase)
+                i = next++;
+    }
+
+    for (int l = 0; l < levels; ++l) {
+        permute_columns(mRes.V(l), order[l]);
+        permute_columns(mRes.N(l), order[l]);
+        permute_entries(mRes.A(l), order[l]);
+        permute_columns(mRes.Q(l), order[l]);
+        permute_columns(mRes.O(l), order[l]);
+        permute_columns(mRes.CQ(l), order[l]);
+        permute_columns(mRes.CO(l), order[l]);
+        permute_entries(mRes.CQw(l), order[l]);
+        permute_entries(mRes.COw(l), order[l]);
+        permute_adjacency(mRes.adj(l), order[l], rank[l], scratch);
+
+        if (l + 1 < levels) {
+            /* toUpper(l): one column per vertex of level l+1, storing level l
+               indices. toLower(l): one entry per vertex of level l, storing
+               level l+1 indices */
+            auto &toUpper = const_cast<MatrixXu &>(mRes.toUpper(l));
+            auto &toLower = const_cast<VectorXu &>(mRes.toLower(l));
+            permute_columns(toUpper, order[l + 1]);
+            remap_indices(toUpper, rank[l]);
+            permute_entries(toLower, order[l]);
+            remap_indices(toLower, rank[l + 1]);
+        }
+    }
+
+    remap_indices(mRes.F(), rank[0]);
+
+    std::set<uint32_t> remapped;
+    for (uint32_t i : creases)
+        remapped.insert(rank[0][i]);
+    creases.swap(remapped);
+
+    cout << "done. (took " << timeString(timer.value()) << ")" << endl;
+}
@@ -0,0 +1,24 @@
+/*
+    hierarchy_layout.h -- Color-contiguous memory layout for the solver phases
+
+    The graph coloring computed by MultiResolutionHierarchy::build() groups
+    the vertices of each level into independent sets that the field solver
+    processes in parallel, one after another. This module renumbers every
+    level so that each color class occupies a contiguous range of columns.
+*/
+
+#pragma once
+
+#include "hierarchy.h"
+#include "arena.h"
+
+/**
+ * Permute the vertices of all hierarchy levels so that the phases become
+ * consecutive index ranges. Per-vertex data, adjacency matrices, the maps
+ * between levels, the level 0 faces and the crease vertex set are updated
+ * accordingly. Within a phase, vertices keep their previous relative order.
+ * Temporaries are allocated from 'arena' if given.
+ */
+extern void make_phases_contiguous(MultiResolutionHierarchy &mRes,
+                                   std::set<uint32_t> &creases,
+                                   JobArena *arena = nullptr);
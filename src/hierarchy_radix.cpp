@@ -0,0 +1,483 @@
+/*
+    hierarchy_radix.cpp -- Hierarchy construction with radix-sorted collapses
+
+    Collapse scores are quantized to single precision and mapped to 32-bit
+    keys whose unsigned order is the order of decreasing score, so that a
+    stable LSD radix sort (four 8-bit passes over per-block histograms)
+    reproduces the order of the comparison sort. The serial greedy pass
+    over the sorted links is replaced by rounds of a locally-dominant
+    matching: every unmatched vertex proposes the unmatched neighbor whose
+    edge comes first in the sorted order, and mutual proposals are matched.
+    With a strict order on the edges, this selects exactly the collapses of
+    the greedy pass. A chain of edges whose order is monotone is matched one
+    edge per round, so after MAX_MATCHING_ROUNDS rounds the remaining edges
+    are left to the serial greedy pass, which picks up where the rounds
+    stopped.
+
+    The level arrays are allocated through HierarchyAccess (see
+    hierarchy_access.h). Scratch buffers come from the job arena when one
+    is given, and every level hands them back when it is done.
+*/
+
+#include "hierarchy_radix.h"
+#include "hierarchy_access.h"
+#include "adjacency.h"
+#include "trace.h"
+
+#include <cstring>
+
+namespace {
+
+const int MAX_LEVELS = 25;
+const uint32_t RADIX_BLOCK_SIZE = 65536;
+const uint32_t COMPACT_BLOCK_SIZE = 16384;
+const uint32_t MAX_MATCHING_ROUNDS = 32;
+
+// Order-preserving map of a float onto an unsigned integer
+inline uint32_t float_key(float value) {
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    return (bits & 0x80000000u) ? ~bits : (bits | 0x80000000u);
+}
+
+/* Stable LSD radix sort of 'values' by 'keys', 8 bits per pass. Every block
+   of the input scatters into its own slice of each bucket, which keeps the
+   passes parallel and stable. Passes over a digit that all keys share are
+   skipped */
+void radix_sort(ArenaVector<uint32_t> &keys, ArenaVector<uint32_t> &values, Arena *scratch) {
+    const uint32_t n = (uint32_t) keys.size();
+    const uint32_t nBlocks = std::max(1u, (n + RADIX_BLOCK_SIZE - 1) / RADIX_BLOCK_SIZE);
+    ArenaAllocator<uint32_t> alloc(scratch);
+    ArenaVector<uint32_t> keys2(n, 0u, alloc), values2(n, 0u, alloc),
+                          offsets(nBlocks * 256, 0u, alloc);
+
+    for (int shift = 0; shift < 32; shift += 8) {
+        tbb::parallel_for(
+            tbb::blocked_range<uint32_t>(0u, nBlocks, 1),
+            [&](const tbb::blocked_range<uint32_t> &range) {
+                for (uint32_t b = range.begin(); b != range.end(); ++b) {
+                    uint32_t *count = &offsets[b * 256];
+                    std::fill(count, count + 256, 0u);
+                    uint32_t end = std::min(n, (b + 1) * RADIX_BLOCK_SIZE);
+                    for (uint32_t i = b * RADIX_BLOCK_SIZE; i < end; ++i)
+                        ++count[(keys[i] >> shift) & 0xFF];
+                }
+            }
+        );
+
+        bool trivial = false;
+        uint32_t sum = 0;
+        for (uint32_t digit = 0; digit < 256; ++digit) {
+            uint32_t digitCount = 0;
+            for (uint32_t b = 0; b < nBlocks; ++b) {
+                uint32_t count = offsets[b * 256 + digit];
+                offsets[b * 256 + digit] = sum;
+                sum += count;
+                digitCount += count;
+            }
+            if (digitCount == n)
+                trivial = true;
+        }
+        if (trivial)
+            continue;
+
+        tbb::parallel_for(
+            tbb::blocked_range<uint32_t>(0u, nBlocks, 1),
+            [&](const tbb::blocked_range<uint32_t> &range) {
+                for (uint32_t b = range.begin(); b != range.end(); ++b) {
+                    uint32_t *offset = &offsets[b * 256];
+                    uint32_t end = std::min(n, (b + 1) * RADIX_BLOCK_SIZE);
+                    for (uint32_t i = b * RADIX_BLOCK_SIZE; i < end; ++i) {
+                        uint32_t dest = offset[(keys[i] >> shift) & 0xFF]++;
+                        keys2[dest] = keys[i];
+                        values2[dest] = values[i];
+                    }
+                }
+            }
+        );
+        keys.swap(keys2);
+        values.swap(values2);
+    }
+}
+
+/* Store value(j) for every j in [0, n) with keep(j) in 'result', in the
+   order of j */
+template <typename Keep, typename Value>
+void parallel_compact(uint32_t n, const Keep &keep, const Value &value,
+                      ArenaVector<uint32_t> &result) {
+    const uint32_t nBlocks = (n + COMPACT_BLOCK_SIZE - 1) / COMPACT_BLOCK_SIZE;
+    ArenaVector<uint32_t> offsets(nBlocks + 1, 0u, result.get_allocator());
+    tbb::parallel_for(
+        tbb::blocked_range<uint32_t>(0u, nBlocks, 1),
+        [&](const tbb::blocked_range<uint32_t> &range) {
+            for (uint32_t b = range.begin(); b != range.end(); ++b) {
+                uint32_t count = 0, end = std::min(n, (b + 1) * COMPACT_BLOCK_SIZE);
+                for (uint32_t j = b * COMPACT_BLOCK_SIZE; j < end; ++j)
+                    count += keep(j) ? 1 : 0;
+                offsets[b + 1] = count;
+            }
+        }
+    );
+    for (uint32_t b = 0; b < nBlocks; ++b)
+        offsets[b + 1] += offsets[b];
+
+    result.resize(offsets[nBlocks]);
+    tbb::parallel_for(
+        tbb::blocked_range<uint32_t>(0u, nBlocks, 1),
+        [&](const tbb::blocked_range<uint32_t> &range) {
+            for (uint32_t b = range.begin(); b != range.end(); ++b) {
+                uint32_t dest = offsets[b], end = std::min(n, (b + 1) * COMPACT_BLOCK_SIZE);
+                for (uint32_t j = b * COMPACT_BLOCK_SIZE; j < end; ++j)
+                    if (keep(j))
+                        result[dest++] = value(j);
+            }
+        }
+    );
+}
+
+} // namespace
+
+uint32_t downsample_graph_radix(const AdjacencyMatrix adj, const MatrixXf &V,
+                                const MatrixXf &N, const VectorXf &A,
+                                MatrixXf &V_p, MatrixXf &N_p, VectorXf &A_p,
+                                MatrixXu &to_upper, VectorXu &to_lower,
+                                AdjacencyMatrix &adj_p, JobArena *arena) {
+    PYIM_TRACE_SCOPE("downsample_graph");
+    const uint32_t n = (uint32_t) V.cols();
+    const uint32_t nLinks = (uint32_t) (adj[n] - adj[0]);
+    const tbb::blocked_range<uint32_t> vertices(0u, n, GRAIN_SIZE);
+
+    /* All scratch buffers of the level are handed back when it is done */
+    Arena *scratch = arena ? &arena->shared() : nullptr;
+    ArenaScope scope(scratch);
+    ArenaAllocator<uint32_t> alloc(scratch);
+
+    /* Sort the links by decreasing score; ties keep the link order */
+    ArenaVector<uint32_t> rank(nLinks, 0u, alloc), order(nLinks, 0u, alloc);
+    tbb::parallel_for(vertices, [&](const tbb::blocked_range<uint32_t> &range) {
+        for (uint32_t i = range.begin(); i != range.end(); ++i) {
+            for (const Link *link = adj[i]; link != adj[i + 1]; ++link) {
+                uint32_t index = (uint32_t) (link - adj[0]), k = link->id;
+                Float dp = N.col(i).dot(N.col(k));
+                Float ratio = A[i] > A[k] ? (A[i] / A[k]) : (A[k] / A[i]);
+                rank[index] = ~float_key((float) (dp * ratio));
+                order[index] = index;
+            }
+        }
+    });
+    radix_sort(rank, order, scratch);
+    tbb::parallel_for(
+        tbb::blocked_range<uint32_t>(0u, nLinks, GRAIN_SIZE),
+        [&](const tbb::blocked_range<uint32_t> &range) {
+            for (uint32_t p = range.begin(); p != range.end(); ++p)
+                rank[order[p]] = p;
+        }
+    );
+    ArenaVector<uint32_t>(alloc).swap(order);
+
+    /* An edge is visited by the greedy pass at the first of its two links */
+    ArenaVector<uint32_t> edgeRank(nLinks, 0u, alloc);
+    tbb::parallel_for(vertices, [&](const tbb::blocked_range<uint32_t> &range) {
+        for (uint32_t i = range.begin(); i != range.end(); ++i) {
+            for (const Link *link = adj[i]; link != adj[i + 1]; ++link) {
+                uint32_t index = (uint32_t) (link - adj[0]), r = rank[index];
+                for (const Link *twin = adj[link->id]; twin != adj[link->id + 1]; ++twin) {
+                    if (twin->id == i) {
+                        r = std::min(r, rank[twin - adj[0]]);
+                        break;
+                    }
+                }
+                edgeRank[index] = r;
+            }
+        }
+    });
+
+    /* Locally-dominant matching: mutual best proposals are final */
+    ArenaVector<uint32_t> mate(n, INVALID, alloc), proposal(n, INVALID, alloc),
+                          active(alloc), next(alloc);
+    parallel_compact(n, [](uint32_t) { return true; }, [](uint32_t i) { return i; }, active);
+    for (uint32_t round = 0; !active.empty() && round < MAX_MATCHING_ROUNDS; ++round) {
+        tbb::parallel_for(
+            tbb::blocked_range<uint32_t>(0u, (uint32_t) active.size(), GRAIN_SIZE),
+            [&](const tbb::blocked_range<uint32_t> &range) {
+                for (uint32_t j = range.begin(); j != range.end(); ++j) {
+                    uint32_t i = active[j], best = INVALID, bestRank = INVALID;
+                    for (const Link *link = adj[i]; link != adj[i + 1]; ++link) {
+                        uint32_t r = edgeRank[link - adj[0]];
+                        if (link->id != i && mate[link->id] == INVALID && r < bestRank) {
+                            best = link->id;
+                            bestRank = r;
+                        }
+                    }
+                    proposal[i] = best;
+                }
+            }
+        );
+        tbb::parallel_for(
+            tbb::blocked_range<uint32_t>(0u, (uint32_t) active.size(), GRAIN_SIZE),
+            [&](const tbb::blocked_range<uint32_t> &range) {
+                for (uint32_t j = range.begin(); j != range.end(); ++j) {
+                    uint32_t i = active[j], k = proposal[i];
+                    if (k != INVALID && proposal[k] == i)
+                        mate[i] = k;
+                }
+            }
+        );
+        parallel_compact((uint32_t) active.size(),
+            [&](uint32_t j) { return mate[active[j]] == INVALID && proposal[active[j]] != INVALID; },
+            [&](uint32_t j) { return active[j]; }, next);
+        active.swap(next);
+    }
+
+    /* Greedy pass over the edges that are still unmatched. The edges matched
+       so far are the first collapses of the greedy pass, so continuing it
+       in rank order gives the same matching */
+    if (!active.empty()) {
+        typedef std::pair<uint32_t, uint32_t> Edge;
+        ArenaVector<Edge> edges(nLinks, Edge(INVALID, INVALID), ArenaAllocator<Edge>(scratch));
+        tbb::parallel_for(vertices, [&](const tbb::blocked_range<uint32_t> &range) {
+            for (uint32_t i = range.begin(); i != range.end(); ++i) {
+                for (const Link *link = adj[i]; link != adj[i + 1]; ++link) {
+                    uint32_t index = (uint32_t) (link - adj[0]);
+                    if (link->id != i && rank[index] == edgeRank[index])
+                        edges[rank[index]] = std::make_pair(i, link->id);
+                }
+            }
+        });
+        for (const auto &edge : edges) {
+            uint32_t i = edge.first, k = edge.second;
+            if (i == INVALID || mate[i] != INVALID || mate[k] != INVALID)
+                continue;
+            mate[i] = k;
+            mate[k] = i;
+        }
+    }
+
+    /* List the collapses in the order of the greedy pass, oriented like the
+       link that ranks first. The rank array is reused for the sources */
+    ArenaVector<uint32_t> &source = rank;
+    tbb::parallel_for(vertices, [&](const tbb::blocked_range<uint32_t> &range) {
+        for (uint32_t i = range.begin(); i != range.end(); ++i) {
+            if (mate[i] == INVALID)
+                continue;
+            for (const Link *link = adj[i]; link != adj[i + 1]; ++link) {
+                uint32_t index = (uint32_t) (link - adj[0]);
+                if (link->id == mate[i] && source[index] == edgeRank[index])
+                    source[index] = INVALID - 1;
+            }
+        }
+    });
+    ArenaVector<uint32_t> collapsed(alloc), uncollapsed(alloc);
+    {
+        /* Invert to position -> source vertex */
+        ArenaVector<uint32_t> bySource(nLinks, INVALID, alloc);
+        tbb::parallel_for(vertices, [&](const tbb::blocked_range<uint32_t> &range) {
+            for (uint32_t i = range.begin(); i != range.end(); ++i)
+                for (const Link *link = adj[i]; link != adj[i + 1]; ++link) {
+                    uint32_t index = (uint32_t) (link - adj[0]);
+                    if (source[index] == INVALID - 1)
+                        bySource[edgeRank[index]] = i;
+                }
+        });
+        parallel_compact(nLinks, [&](uint32_t r) { return bySource[r] != INVALID; },
+                         [&](uint32_t r) { return bySource[r]; }, collapsed);
+    }
+    parallel_compact(n, [&](uint32_t i) { return mate[i] == INVALID; },
+                     [](uint32_t i) { return i; }, uncollapsed);
+
+    const uint32_t nCollapsed = (uint32_t) collapsed.size();
+    const uint32_t vertexCount = n - nCollapsed;
+    V_p.resize(3, vertexCount);
+    N_p.resize(3, vertexCount);
+    A_p.resize(vertexCount);
+    to_upper.resize(2, vertexCount);
+    to_lower.resize(n);
+
+    tbb::parallel_for(
+        tbb::blocked_range<uint32_t>(0u, nCollapsed, GRAIN_SIZE),
+        [&](const tbb::blocked_range<uint32_t> &range) {
+            for (uint32_t c = range.begin(); c != range.end(); ++c) {
+                uint32_t i0 = collapsed[c], i1 = mate[i0];
+                const Float area1 = A[i0], area2 = A[i1], surfaceArea = area1 + area2;
+                if (surfaceArea > RCPOVERFLOW)
+                    V_p.col(c) = (V.col(i0) * area1 + V.col(i1) * area2) / surfaceArea;
+                else
+                    V_p.col(c) = (V.col(i0) + V.col(i1)) * 0.5f;
+                Vector3f normal = N.col(i0) * area1 + N.col(i1) * area2;
+                Float norm = normal.norm();
+                N_p.col(c) = norm > RCPOVERFLOW ? Vector3f(normal / norm)
+                                                : Vector3f::UnitX();
+                A_p[c] = surfaceArea;
+                to_upper.col(c) << i0, i1;
+                to_lower[i0] = to_lower[i1] = c;
+            }
+        }
+    );
+
+    tbb::parallel_for(
+        tbb::blocked_range<uint32_t>(0u, (uint32_t) uncollapsed.size(), GRAIN_SIZE),
+        [&](const tbb::blocked_range<uint32_t> &range) {
+            for (uint32_t j = range.begin(); j != range.end(); ++j) {
+                uint32_t i = uncollapsed[j], idx = nCollapsed + j;
+                V_p.col(idx) = V.col(i);
+                N_p.col(idx) = N.col(i);
+                A_p[idx] = A[i];
+                to_upper.col(idx) << i, INVALID;
+                to_lower[i] = idx;
+            }
+        }
+    );
+
+    /* Merge the neighborhoods of the collapsed pairs */
+    auto gather_links = [&](uint32_t i, ArenaVector<Link> &result) {
+        result.clear();
+        for (int j = 0; j < 2; ++j) {
+            uint32_t upper = to_upper(j, i);
+            if (upper == INVALID)
+                continue;
+            for (const Link *link = adj[upper]; link != adj[upper + 1]; ++link)
+                result.push_back(Link(to_lower[link->id], link->weight));
+        }
+        std::sort(result.begin(), result.end());
+    };
+
+    VectorXu neighborhoodSize(vertexCount + 1);
+    neighborhoodSize[0] = 0;
+    tbb::parallel_for(
+        tbb::blocked_range<uint32_t>(0u, vertexCount, GRAIN_SIZE),
+        [&](const tbb::blocked_range<uint32_t> &range) {
+            Arena *local = arena ? &arena->local() : nullptr;
+            ArenaScope taskScope(local);
+            ArenaAllocator<Link> linkAlloc(local);
+            ArenaVector<Link> neighbors(linkAlloc);
+            for (uint32_t i = range.begin(); i != range.end(); ++i) {
+                gather_links(i, neighbors);
+                uint32_t id = INVALID, size = 0;
+                for (const Link &link : neighbors) {
+                    if (id != link.id && link.id != i) {
+                        id = link.id;
+                        ++size;
+                    }
+                }
+                neighborhoodSize[i + 1] = size;
+            }
+        }
+    );
+    for (uint32_t i = 0; i < vertexCount; ++i)
+        neighborhoodSize[i + 1] += neighborhoodSize[i];
+
+    uint32_t nLinks_p = neighborhoodSize[vertexCount];
+    adj_p = new Link*[vertexCount + 1];
+    Link *links = new Link[nLinks_p];
+    for (uint32_t i = 0; i <= vertexCount; ++i)
+        adj_p[i] = links + neighborhoodSize[i];
+
+    tbb::parallel_for(
+        tbb::blocked_range<uint32_t>(0u, vertexCount, GRAIN_SIZE),
+        [&](const tbb::blocked_range<uint32_t> &range) {
+            Arena *local = arena ? &arena->local() : nullptr;
+            ArenaScope taskScope(local);
+            ArenaAllocator<Link> linkAlloc(local);
+            ArenaVector<Link> neighbors(linkAlloc);
+            for (uint32_t i = range.begin(); i != range.end(); ++i) {
+                gather_links(i, neighbors);
+                Link *dest = adj_p[i];
+                uint32_t id = INVALID;
+                for (const Link &link : neighbors) {
+                    if (link.id == i)
+                        continue;
+                    if (id != link.id) {
+                        *dest++ = link;
+                        id = link.id;
+                    } else {
+                        dest[-1].weight += link.weight;
+                    }
+                }
+            }
+        }
+    );
+
+    return nCollapsed;
+}
+
+void build_hierarchy_radix(MultiResolutionHierarchy &mRes, bool deterministic,
+                           JobArena *arena) {
+    PYIM_TRACE_SCOPE("build_hierarchy_radix");
+    cout << "Building multiresolution hierarchy with radix-sorted collapses .. ";
+    cout.flush();
+    Timer<> timer;
+
+    auto &adj = HierarchyAccess::adj(mRes);
+    auto &V = HierarchyAccess::V(mRes);
+    auto &N = HierarchyAccess::N(mRes);
+    auto &A = HierarchyAccess::A(mRes);
+    auto &toUpper = HierarchyAccess::toUpper(mRes);
+    auto &toLower = HierarchyAccess::toLower(mRes);
+
+    /* Keep level 0 only, in case the hierarchy was built before */
+    for (size_t l = 1; l < adj.size(); ++l) {
+        delete[] adj[l][0];
+        delete[] adj[l];
+    }
+    adj.resize(1);
+    V.resize(1);
+    N.resize(1);
+    A.resize(1);
+    toUpper.clear();
+    toLower.clear();
+    HierarchyAccess::totalSize(mRes) = V[0].cols();
+
+    for (int l = 0; l + 1 < MAX_LEVELS && V[l].cols() > 1; ++l) {
+        PYIM_TRACE_SCOPE("hierarchy_level", l);
+        MatrixXf V_p, N_p;
+        VectorXf A_p;
+        MatrixXu to_upper;
+        VectorXu to_lower;
+        AdjacencyMatrix adj_p;
+        uint32_t nCollapsed = downsample_graph_radix(adj[l], V[l], N[l], A[l], V_p, N_p, A_p,
+                                                     to_upper, to_lower, adj_p, arena);
+        if (nCollapsed == 0) {
+            delete[] adj_p[0];
+            delete[] adj_p;
+            break;
+        }
+        HierarchyAccess::totalSize(mRes) += V_p.cols();
+        adj.push_back(adj_p);
+        V.push_back(std::move(V_p));
+        N.push_back(std::move(N_p));
+        A.push_back(std::move(A_p));
+        toUpper.push_back(std::move(to_upper));
+        toLower.push_back(std::move(to_lower));
+    }
+
+    /* Field and constraint arrays, and the graph coloring of every level */
+    const size_t levels = V.size();
+    auto &Q = HierarchyAccess::Q(mRes), &O = HierarchyAccess::O(mRes);
+    auto &CQ = HierarchyAccess::CQ(mRes), &CO = HierarchyAccess::CO(mRes);
+    auto &CQw = HierarchyAccess::CQw(mRes), &COw = HierarchyAccess::COw(mRes);
+    auto &phases = HierarchyAccess::phases(mRes);
+    Q.resize(levels);
+    O.resize(levels);
+    CQ.resize(levels);
+    CO.resize(levels);
+    CQw.resize(levels);
+    COw.resize(levels);
+    phases.resize(levels);
+    for (size_t l = 0; l < levels; ++l) {
+        PYIM_TRACE_SCOPE("coloring_level", (int32_t) l);
+        const uint32_t size = (uint32_t) V[l].cols();
+        Q[l].resize(3, size);
+        O[l].resize(3, size);
+        CQ[l].setZero(3, size);
+        CO[l].setZero(3, size);
+        CQw[l].setZero(size);
+        COw[l].setZero(size);
+        phases[l].clear();
+        if (deterministic)
+            generate_graph_coloring_deterministic(adj[l], size, phases[l], ProgressCallback());
+        else
+            generate_graph_coloring(adj[l], size, phases[l], ProgressCallback());
+    }
+
+    cout << "done. (" << levels << " levels, took " << timeString(timer.value()) << ")" << endl;
+}
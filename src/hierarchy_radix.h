@@ -0,0 +1,39 @@
+/*
+    hierarchy_radix.h -- Hierarchy construction with radix-sorted collapses
+
+    MultiResolutionHierarchy::build() coarsens every level by a greedy
+    matching over all links, visited in the order of decreasing collapse
+    score after a comparison sort. This module computes the same matching
+    from 32-bit score keys that are ordered by a parallel LSD radix sort,
+    and selects the collapses with a parallel locally-dominant matching.
+*/
+
+#pragma once
+
+#include "hierarchy.h"
+#include "arena.h"
+
+/**
+ * Coarsen one level. The score of the link i -> j is
+ * dot(N_i, N_j) * max(A_i / A_j, A_j / A_i), and links are collapsed
+ * greedily in the order of decreasing score, ties broken by link index.
+ * The output has the layout of downsample_graph() from hierarchy.cpp:
+ * collapsed pairs come first, in the order they were matched, followed by
+ * the unmatched vertices in index order. Returns the number of collapses.
+ * Temporaries are allocated from 'arena' if given.
+ */
+extern uint32_t downsample_graph_radix(const AdjacencyMatrix adj, const MatrixXf &V,
+                                       const MatrixXf &N, const VectorXf &A,
+                                       MatrixXf &V_p, MatrixXf &N_p, VectorXf &A_p,
+                                       MatrixXu &to_upper, VectorXu &to_lower,
+                                       AdjacencyMatrix &adj_p, JobArena *arena = nullptr);
+
+/**
+ * Replacement for MultiResolutionHierarchy::build() that coarsens with
+ * downsample_graph_radix(). Level 0 must have been set up with setAdj(),
+ * setV(), setN() and setA(). The field and constraint arrays of all levels
+ * are allocated; call resetSolution() before solving, as after build().
+ * The temporaries of every level are allocated from 'arena' if given.
+ */
+extern void build_hierarchy_radix(MultiResolutionHierarchy &mRes, bool deterministic,
+                                  JobArena *arena = nullptr);
@@ -0,0 +1,82 @@
+/*
+    hierarchy_share.cpp -- Hierarchies that share the adjacency of another one
+
+    The adjacency matrices are plain pointers in MultiResolutionHierarchy,
+    which frees them in its destructor. The shared ones are dropped from the
+    level list before that happens.
+*/
+
+#include "hierarchy_share.h"
+#include "hierarchy_access.h"
+#include "hugepages.h"
+#include "trace.h"
+
+namespace {
+
+// Give 'M' a new allocation of the given size, advised for huge pages if requested
+template <typename Matrix>
+void allocate(Matrix &M, Eigen::Index rows, Eigen::Index cols, bool hugePages) {
+    M.resize(rows, cols);
+    if (hugePages)
+        advise_huge_pages(M.data(), M.size() * sizeof(typename Matrix::Scalar));
+}
+
+// Copy every level of 'src' into a new allocation
+template <typename Matrix>
+void copy_levels(std::vector<Matrix> &dst, const std::vector<Matrix> &src, bool hugePages) {
+    dst.resize(src.size());
+    for (size_t l = 0; l < src.size(); ++l) {
+        allocate(dst[l], src[l].rows(), src[l].cols(), hugePages);
+        dst[l] = src[l];
+    }
+}
+
+} // namespace
+
+SharedHierarchy::SharedHierarchy(const MultiResolutionHierarchy &constSource, bool hugePages) {
+    PYIM_TRACE_SCOPE("share_hierarchy");
+    /* Only read; the accessors are not const */
+    MultiResolutionHierarchy &source = const_cast<MultiResolutionHierarchy &>(constSource);
+
+    copy_levels(HierarchyAccess::V(mRes), HierarchyAccess::V(source), hugePages);
+    copy_levels(HierarchyAccess::N(mRes), HierarchyAccess::N(source), hugePages);
+    copy_levels(HierarchyAccess::A(mRes), HierarchyAccess::A(source), hugePages);
+    HierarchyAccess::toUpper(mRes) = HierarchyAccess::toUpper(source);
+    HierarchyAccess::toLower(mRes) = HierarchyAccess::toLower(source);
+    HierarchyAccess::phases(mRes) = HierarchyAccess::phases(source);
+    HierarchyAccess::totalSize(mRes) = HierarchyAccess::totalSize(source);
+    mRes.setF(MatrixXu(source.F()));
+    mRes.setE2E(VectorXu(source.E2E()));
+    mRes.setScale(source.scale());
+
+    const size_t levels = HierarchyAccess::V(mRes).size();
+    auto &Q = HierarchyAccess::Q(mRes), &O = HierarchyAccess::O(mRes);
+    auto &CQ = HierarchyAccess::CQ(mRes), &CO = HierarchyAccess::CO(mRes);
+    auto &CQw = HierarchyAccess::CQw(mRes), &COw = HierarchyAccess::COw(mRes);
+    Q.resize(levels);
+    O.resize(levels);
+    CQ.resize(levels);
+    CO.resize(levels);
+    CQw.resize(levels);
+    COw.resize(levels);
+    for (size_t l = 0; l < levels; ++l) {
+        const Eigen::Index size = HierarchyAccess::V(mRes)[l].cols();
+        allocate(Q[l], 3, size, hugePages);
+        allocate(O[l], 3, size, hugePages);
+        allocate(CQ[l], 3, size, hugePages);
+        allocate(CO[l], 3, size, hugePages);
+        allocate(CQw[l], size, 1, hugePages);
+        allocate(COw[l], size, 1, hugePages);
+        CQ[l].setZero();
+        CO[l].setZero();
+        CQw[l].setZero();
+        COw[l].setZero();
+    }
+
+    /* Last, so that mRes never frees the shared matrices if a copy throws */
+    HierarchyAccess::adj(mRes) = HierarchyAccess::adj(source);
+}
+
+SharedHierarchy::~SharedHierarchy() {
+    HierarchyAccess::adj(mRes).clear();
+}
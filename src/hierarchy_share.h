@@ -0,0 +1,33 @@
+/*
+    hierarchy_share.h -- Hierarchies that share the adjacency of another one
+
+    The jobs of a parameter sweep that only differ in their symmetry, target
+    size or solver settings can all solve on the same hierarchy levels. The
+    solver and the extraction only read the adjacency matrices, which take
+    most of the memory of a hierarchy, so every job refers to those of one
+    shared hierarchy. The per-vertex arrays are copied, since
+    MultiResolutionHierarchy holds them by value.
+*/
+
+#pragma once
+
+#include "hierarchy.h"
+
+/* Hierarchy with the levels of 'source' and its own field and constraint
+   arrays. 'source' is not modified, and must neither change nor be
+   destroyed while this object exists. With hugePages, the copied arrays
+   are advised for transparent huge pages before they are written. Call
+   resetSolution() before solving */
+class SharedHierarchy {
+public:
+    explicit SharedHierarchy(const MultiResolutionHierarchy &source, bool hugePages = false);
+    ~SharedHierarchy();
+
+    MultiResolutionHierarchy &get() { return mRes; }
+
+private:
+    SharedHierarchy(const SharedHierarchy &) = delete;
+    SharedHierarchy &operator=(const SharedHierarchy &) = delete;
+
+    MultiResolutionHierarchy mRes;
+};
@@ -0,0 +1,140 @@
+/*
+    hugepages.cpp -- Transparent huge pages for large solver arrays
+
+    MultiResolutionHierarchy holds its arrays as Eigen matrices and frees
+    the adjacency link blocks with delete[], so they cannot come from a
+    dedicated 2 MB aligned allocator. Instead, the 2 MB aligned interior of
+    every freshly allocated buffer is advised before the buffer is first
+    written. Large buffers are mmap()ed by malloc and still untouched at
+    that point, so the kernel can back the advised part with huge pages;
+    the unaligned head and tail of each buffer (less than 4 MB in total)
+    keep small pages.
+
+    madvise() splits the advised interiors into mappings of their own with
+    the 'hg' flag. Huge page usage is read from the AnonHugePages field of
+    those mappings in /proc/self/smaps, counting only mappings that lie
+    within the advised parts of the hierarchy. An advised mapping that the
+    kernel merged with an advised neighbor outside the hierarchy is not
+    counted, so the result is a lower bound.
+*/
+
+#include "hugepages.h"
+
+#include <algorithm>
+#include <cctype>
+#include <fstream>
+#include <limits>
+#include <sstream>
+
+#if defined(__linux__)
+#include <sys/mman.h>
+#endif
+
+namespace {
+
+typedef std::pair<uintptr_t, uintptr_t> AddressRange;
+
+// The part of [ptr, ptr + size) that advise_huge_pages() advises
+AddressRange aligned_interior(const void *ptr, size_t size) {
+    uintptr_t begin = ((uintptr_t) ptr + HUGE_PAGE_SIZE - 1) & ~(uintptr_t) (HUGE_PAGE_SIZE - 1);
+    uintptr_t end = ((uintptr_t) ptr + size) & ~(uintptr_t) (HUGE_PAGE_SIZE - 1);
+    return AddressRange(begin, std::max(begin, end));
+}
+
+void add_range(std::vector<AddressRange> &ranges, const void *ptr, size_t size) {
+    AddressRange range = aligned_interior(ptr, size);
+    if (range.second > range.first)
+        ranges.push_back(range);
+}
+
+template <typename Matrix>
+void add_range(std::vector<AddressRange> &ranges, const Matrix &M) {
+    add_range(ranges, M.data(), M.size() * sizeof(typename Matrix::Scalar));
+}
+
+// Sort the ranges and merge the ones that touch
+void merge_ranges(std::vector<AddressRange> &ranges) {
+    std::sort(ranges.begin(), ranges.end());
+    size_t count = 0;
+    for (const AddressRange &range : ranges) {
+        if (count > 0 && range.first <= ranges[count - 1].second)
+            ranges[count - 1].second = std::max(ranges[count - 1].second, range.second);
+        else
+            ranges[count++] = range;
+    }
+    ranges.resize(count);
+}
+
+// Is [begin, end) inside one of the merged 'ranges'?
+bool contains(const std::vector<AddressRange> &ranges, uintptr_t begin, uintptr_t end) {
+    auto it = std::upper_bound(ranges.begin(), ranges.end(),
+                               AddressRange(begin, std::numeric_limits<uintptr_t>::max()));
+    return it != ranges.begin() && (--it)->first <= begin && end <= it->second;
+}
+
+} // namespace
+
+void advise_huge_pages(void *ptr, size_t size) {
+#if defined(__linux__) && defined(MADV_HUGEPAGE)
+    AddressRange range = aligned_interior(ptr, size);
+    if (range.second > range.first)
+        madvise((void *) range.first, range.second - range.first, MADV_HUGEPAGE);
+#else
+    (void) ptr;
+    (void) size;
+#endif
+}
+
+size_t hierarchy_huge_pages(MultiResolutionHierarchy &mRes) {
+#if defined(__linux__)
+    std::vector<AddressRange> ranges;
+    for (int l = 0; l < mRes.levels(); ++l) {
+        add_range(ranges, mRes.V(l));
+        add_range(ranges, mRes.N(l));
+        add_range(ranges, mRes.A(l));
+        add_range(ranges, mRes.Q(l));
+        add_range(ranges, mRes.O(l));
+        add_range(ranges, mRes.CQ(l));
+        add_range(ranges, mRes.CO(l));
+        add_range(ranges, mRes.CQw(l));
+        add_range(ranges, mRes.COw(l));
+        AdjacencyMatrix adj = mRes.adj(l);
+        if (adj && mRes.size(l) > 0)
+            add_range(ranges, adj[0], (adj[mRes.size(l)] - adj[0]) * sizeof(Link));
+    }
+    merge_ranges(ranges);
+
+    /* Every mapping is a header line followed by its fields, VmFlags last */
+    std::ifstream smaps("/proc/self/smaps");
+    std::string line;
+    uintptr_t begin = 0, end = 0;
+    size_t mappingKilobytes = 0, kilobytes = 0;
+    while (std::getline(smaps, line)) {
+        if (line.empty())
+            continue;
+        if (std::isxdigit((unsigned char) line[0]) && line.find('-') != std::string::npos &&
+            line.find(':') > line.find(' ')) {
+            /* Mapping header: "start-end perms offset dev inode path" */
+            std::istringstream is(line);
+            char dash;
+            is >> std::hex >> begin >> dash >> end;
+            mappingKilobytes = 0;
+        } else if (line.compare(0, 14, "AnonHugePages:") == 0) {
+            std::istringstream is(line.substr(14));
+            is >> mappingKilobytes;
+        } else if (line.compare(0, 8, "VmFlags:") == 0) {
+            std::istringstream is(line.substr(8));
+            std::string flag;
+            bool advised = false;
+            while (is >> flag)
+                advised |= flag == "hg";
+            if (advised && contains(ranges, begin, end))
+                kilobytes += mappingKilobytes;
+        }
+    }
+    return kilobytes * 1024 / HUGE_PAGE_SIZE;
+#else
+    (void) mRes;
+    return 0;
+#endif
+}
@@ -0,0 +1,23 @@
+/*
+    hugepages.h -- Transparent huge pages for large solver arrays
+
+    The field solver walks the adjacency matrix and gathers neighbor data
+    from all over the per-vertex arrays, so multi-GB hierarchies spend a
+    lot of time on TLB misses with 4 KB pages. Buffers that are advised
+    with MADV_HUGEPAGE before they are first touched get 2 MB pages from
+    the kernel whenever transparent huge pages are enabled in 'madvise' or
+    'always' mode. On other platforms these functions do nothing.
+*/
+
+#pragma once
+
+#include "hierarchy.h"
+
+static const size_t HUGE_PAGE_SIZE = 2 * 1024 * 1024;
+
+// Request huge pages for the 2 MB aligned part of [ptr, ptr + size)
+extern void advise_huge_pages(void *ptr, size_t size);
+
+/* Number of huge pages backing the advised parts of the per-level arrays
+   and adjacency matrices; a lower bound (see hugepages.cpp) */
+extern size_t hierarchy_huge_pages(MultiResolutionHierarchy &mRes);
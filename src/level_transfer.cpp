@@ -0,0 +1,169 @@
+/*
+    level_transfer.cpp -- Parallel transfers between hierarchy levels
+
+    The prolongation kernels process the coarse vertices in blocks: the
+    coarse field values, and the normals and positions of one child slot,
+    are gathered into arrays with one contiguous column per coordinate (see
+    face_block.h), projected by vectorized array expressions and scattered
+    back. Children are never shared between parents, so blocks are
+    independent. Constraint restriction follows propagateConstraints() of
+    hierarchy.cpp with one parallel loop per level instead of a serial one.
+*/
+
+#include "level_transfer.h"
+#include "face_block.h"
+#include "field.h"
+#include "trace.h"
+
+namespace {
+
+const uint32_t BLOCK_SIZE = 1024;
+
+// Gather the columns 'index' of 'M' into a block; INVALID rows are zero
+inline void gather_columns(const MatrixXf &M, const uint32_t *index, uint32_t n,
+                           PointBlock &block) {
+    block.resize(n, 3);
+    for (uint32_t j = 0; j < n; ++j) {
+        if (index[j] == INVALID)
+            block.row(j).setZero();
+        else
+            block.row(j) = M.col(index[j]).transpose().array();
+    }
+}
+
+/* Prolong 'src' of 'level' into 'dest' of level - 1, projecting it onto the
+   tangent planes of the children. With 'offsets', the projection is about
+   the child positions (position field), otherwise about the origin */
+void prolong_field(const MultiResolutionHierarchy &mRes, int level,
+                   const MatrixXf &src, MatrixXf &dest, bool offsets) {
+    PYIM_TRACE_SCOPE("prolong", level);
+    const MatrixXu &toUpper = mRes.toUpper(level - 1);
+    const MatrixXf &N = mRes.N(level - 1), &V = mRes.V(level - 1);
+    const uint32_t size = (uint32_t) src.cols();
+    const uint32_t nBlocks = (size + BLOCK_SIZE - 1) / BLOCK_SIZE;
+
+    tbb::parallel_for(
+        tbb::blocked_range<uint32_t>(0u, nBlocks, 1),
+        [&](const tbb::blocked_range<uint32_t> &range) {
+            PointBlock value, n, v, result;
+            uint32_t child[BLOCK_SIZE];
+            for (uint32_t b = range.begin(); b != range.end(); ++b) {
+                PYIM_TRACE_SCOPE("prolong_block", level);
+                uint32_t begin = b * BLOCK_SIZE,
+                         count = std::min(begin + BLOCK_SIZE, size) - begin;
+                value.resize(count, 3);
+                for (uint32_t j = 0; j < count; ++j)
+                    value.row(j) = src.col(begin + j).transpose().array();
+
+                for (int k = 0; k < 2; ++k) {
+                    for (uint32_t j = 0; j < count; ++j)
+                        child[j] = toUpper(k, begin + j);
+                    gather_columns(N, child, count, n);
+                    if (offsets) {
+                        gather_columns(V, child, count, v);
+                        result = value - n.colwise() * block_dot(n, value - v);
+                    } else {
+                        result = value - n.colwise() * block_dot(n, value);
+                    }
+                    for (uint32_t j = 0; j < count; ++j)
+                        if (child[j] != INVALID)
+                            dest.col(child[j]) = result.row(j).transpose().matrix();
+                }
+            }
+        }
+    );
+}
+
+} // namespace
+
+void prolong_orientations(MultiResolutionHierarchy &mRes, int level) {
+    prolong_field(mRes, level, mRes.Q(level), mRes.Q(level - 1), false);
+}
+
+void prolong_positions(MultiResolutionHierarchy &mRes, int level) {
+    prolong_field(mRes, level, mRes.O(level), mRes.O(level - 1), true);
+}
+
+void restrict_constraints(MultiResolutionHierarchy &mRes, int rosy, int posy) {
+    PYIM_TRACE_SCOPE("restrict_constraints");
+    if (mRes.levels() == 0)
+        return;
+    cout << "Propagating constraints in parallel .. ";
+    cout.flush();
+    Timer<> timer;
+
+    auto compat_orientation = rosy == 2 ? compat_orientation_extrinsic_2 :
+        (rosy == 4 ? compat_orientation_extrinsic_4 : compat_orientation_extrinsic_6);
+    auto compat_position = posy == 4 ? compat_position_extrinsic_4 : compat_position_extrinsic_3;
+    const Float scale = mRes.scale(), inv_scale = 1.0f / scale;
+
+    for (int l = 0; l < mRes.levels() - 1; ++l) {
+        PYIM_TRACE_SCOPE("restrict_level", l);
+        const MatrixXf &N = mRes.N(l), &N_next = mRes.N(l + 1);
+        const MatrixXf &V = mRes.V(l), &V_next = mRes.V(l + 1);
+        const MatrixXf &CQ = mRes.CQ(l), &CO = mRes.CO(l);
+        const VectorXf &CQw = mRes.CQw(l), &COw = mRes.COw(l);
+        MatrixXf &CQ_next = mRes.CQ(l + 1), &CO_next = mRes.CO(l + 1);
+        VectorXf &CQw_next = mRes.CQw(l + 1), &COw_next = mRes.COw(l + 1);
+        const MatrixXu &toUpper = mRes.toUpper(l);
+
+        tbb::parallel_for(
+            tbb::blocked_range<uint32_t>(0u, (uint32_t) mRes.size(l + 1), GRAIN_SIZE),
+            [&](const tbb::blocked_range<uint32_t> &range) {
+                for (uint32_t i = range.begin(); i != range.end(); ++i) {
+                    uint32_t u0 = toUpper(0, i), u1 = toUpper(1, i);
+                    Vector3f cq = Vector3f::Zero(), co = Vector3f::Zero();
+                    Float cqw = 0, cow = 0;
+
+                    bool has_cq0 = CQw[u0] != 0, has_cq1 = u1 != INVALID && CQw[u1] != 0;
+                    bool has_co0 = COw[u0] != 0, has_co1 = u1 != INVALID && COw[u1] != 0;
+
+                    if (has_cq0 && !has_cq1) {
+                        cq = CQ.col(u0);
+                        cqw = CQw[u0];
+                    } else if (has_cq1 && !has_cq0) {
+                        cq = CQ.col(u1);
+                        cqw = CQw[u1];
+                    } else if (has_cq0 && has_cq1) {
+                        auto result = compat_orientation(CQ.col(u0), N.col(u0),
+                                                         CQ.col(u1), N.col(u1));
+                        cq = result.first * CQw[u0] + result.second * CQw[u1];
+                        cqw = CQw[u0] + CQw[u1];
+                    }
+                    if (cq != Vector3f::Zero()) {
+                        Vector3f n = N_next.col(i);
+                        cq -= n.dot(cq) * n;
+                        if (cq.squaredNorm() > RCPOVERFLOW)
+                            cq.normalize();
+                    }
+
+                    if (has_co0 && !has_co1) {
+                        co = CO.col(u0);
+                        cow = COw[u0];
+                    } else if (has_co1 && !has_co0) {
+                        co = CO.col(u1);
+                        cow = COw[u1];
+                    } else if (has_co0 && has_co1) {
+                        auto result = compat_position(
+                            V.col(u0), N.col(u0), CQ.col(u0), CO.col(u0),
+                            V.col(u1), N.col(u1), CQ.col(u1), CO.col(u1),
+                            scale, inv_scale);
+                        cow = COw[u0] + COw[u1];
+                        co = (result.first * COw[u0] + result.second * COw[u1]) / cow;
+                    }
+                    if (co != Vector3f::Zero()) {
+                        Vector3f n = N_next.col(i), v = V_next.col(i);
+                        co -= n.dot(co - v) * n;
+                    }
+
+                    CQw_next[i] = cqw > 0 ? 1.0f : 0.0f;
+                    COw_next[i] = cow > 0 ? 1.0f : 0.0f;
+                    CQ_next.col(i) = cq;
+                    CO_next.col(i) = co;
+                }
+            }
+        );
+    }
+
+    cout << "done. (took " << timeString(timer.value()) << ")" << endl;
+}
@@ -0,0 +1,26 @@
+/*
+    level_transfer.h -- Parallel transfers between hierarchy levels
+
+    Every coarse vertex of a MultiResolutionHierarchy level has one or two
+    children on the next finer level (see toUpper()). Prolongation copies a
+    coarse field value to the children and projects it onto their tangent
+    planes; restriction combines the values of the children into their
+    parent. Both are per-vertex gathers with disjoint outputs.
+*/
+
+#pragma once
+
+#include "hierarchy.h"
+
+// Copy the orientation field of 'level' to level - 1
+extern void prolong_orientations(MultiResolutionHierarchy &mRes, int level);
+
+// Copy the position field of 'level' to level - 1
+extern void prolong_positions(MultiResolutionHierarchy &mRes, int level);
+
+/**
+ * Restrict the orientation and position constraints of level 0 to all
+ * coarser levels. Equivalent to MultiResolutionHierarchy::propagateConstraints(),
+ * but every level is processed by a parallel loop over its vertices.
+ */
+extern void restrict_constraints(MultiResolutionHierarchy &mRes, int rosy, int posy);
@@ -0,0 +1,80 @@
+/*
+    logging.cpp -- Pluggable log sink for the progress output of a job
+*/
+
+#include "logging.h"
+
+#include <atomic>
+#include <iostream>
+#include <mutex>
+
+namespace {
+
+std::mutex sinkMutex;
+std::shared_ptr<LogSink> sink;
+std::atomic<int> sinkLevel((int) LogLevel::Off);
+
+} // namespace
+
+/* Collects the characters written to std::cout and emits one record per
+   complete line. Flushes (e.g. after "Building hierarchy .. ") are ignored,
+   so that a stage and its timing end up in the same record */
+class LogCapture::LineBuffer : public std::streambuf {
+public:
+    ~LineBuffer() { emit(); }
+
+    void emit() {
+        if (!mLine.empty())
+            log_message(LogLevel::Info, mLine);
+        mLine.clear();
+    }
+
+protected:
+    int_type overflow(int_type c) override {
+        if (traits_type::eq_int_type(c, traits_type::eof()))
+            return traits_type::not_eof(c);
+        if (traits_type::to_char_type(c) == '\n')
+            emit();
+        else
+            mLine.push_back(traits_type::to_char_type(c));
+        return c;
+    }
+
+private:
+    std::string mLine;
+};
+
+void set_log_sink(std::shared_ptr<LogSink> newSink, LogLevel level) {
+    std::lock_guard<std::mutex> lock(sinkMutex);
+    sink = std::move(newSink);
+    sinkLevel = sink ? (int) level : (int) LogLevel::Off;
+}
+
+bool log_enabled(LogLevel level) {
+    return level != LogLevel::Off && (int) level >= sinkLevel.load(std::memory_order_relaxed);
+}
+
+void log_message(LogLevel level, const std::string &message) {
+    if (!log_enabled(level))
+        return;
+    std::shared_ptr<LogSink> target;
+    {
+        std::lock_guard<std::mutex> lock(sinkMutex);
+        target = sink;
+    }
+    if (target)
+        target->write(level, message);
+}
+
+LogCapture::LogCapture(bool silent) : mBuffer(new LineBuffer()) {
+    // rdbuf() clears the stream state, so save it first
+    mState = std::cout.rdstate();
+    mPrevious = std::cout.rdbuf(mBuffer.get());
+    if (silent || !log_enabled(LogLevel::Info))
+        std::cout.setstate(std::ios_base::badbit);
+}
+
+LogCapture::~LogCapture() {
+    std::cout.rdbuf(mPrevious);
+    std::cout.clear(mState);
+}
@@ -0,0 +1,74 @@
+/*
+    logging.h -- Pluggable log sink for the progress output of a job
+
+    The instant-meshes stages report their progress by writing to std::cout.
+    While a job runs, LogCapture takes over std::cout: complete lines are
+    passed to the installed LogSink as records with a level, and if no sink
+    wants Info records, std::cout is put into a failed state so that the
+    stream insertions of all stages return before formatting anything. The
+    bindings are silent by default.
+*/
+
+#pragma once
+
+#include "common.h"
+#include <memory>
+#include <sstream>
+#include <streambuf>
+
+// Severity of a record; the values match the levels of Python's logging module
+enum class LogLevel : int {
+    Debug = 10,
+    Info = 20,
+    Warning = 30,
+    Error = 40,
+    Off = 100
+};
+
+// Receiver of log records. write() may be called from any thread
+class LogSink {
+public:
+    virtual ~LogSink() { }
+    virtual void write(LogLevel level, const std::string &message) = 0;
+};
+
+/* Install 'sink' for all records at or above 'level'. A null sink or
+   LogLevel::Off disables logging */
+extern void set_log_sink(std::shared_ptr<LogSink> sink, LogLevel level);
+
+// Is there a sink for records of this level?
+extern bool log_enabled(LogLevel level);
+
+// Pass a record to the installed sink, if enabled
+extern void log_message(LogLevel level, const std::string &message);
+
+/* Log a record built with stream insertions, e.g.
+   PYIM_LOG(LogLevel::Warning, "Dropped " << n << " faces"). The insertions
+   are only evaluated if the level is enabled */
+#define PYIM_LOG(level, expr)                                               \
+    do {                                                                    \
+        if (log_enabled(level)) {                                           \
+            std::ostringstream pyim_log_stream_;                            \
+            pyim_log_stream_ << expr;                                       \
+            log_message(level, pyim_log_stream_.str());                     \
+        }                                                                   \
+    } while (0)
+
+/* Route std::cout to the log sink as Info records for the lifetime of this
+   object, and restore the previous stream buffer and state afterwards. With
+   'silent', the output is discarded even if the sink wants Info records,
+   e.g. while several jobs write to std::cout concurrently */
+class LogCapture {
+public:
+    explicit LogCapture(bool silent = false);
+    ~LogCapture();
+
+private:
+    LogCapture(const LogCapture &) = delete;
+    LogCapture &operator=(const LogCapture &) = delete;
+
+    class LineBuffer;
+    std::unique_ptr<LineBuffer> mBuffer;
+    std::streambuf *mPrevious;
+    std::ios_base::iostate mState;
+};
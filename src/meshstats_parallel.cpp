@@ -0,0 +1,144 @@
+/*
+    meshstats_parallel.cpp -- Fused mesh statistics and dual vertex areas
+
+    Every block of faces is gathered once (see face_block.h) and yields its
+    edge length sum and maximum, surface area, area-weighted center and
+    bounding box as vectorized reductions, plus the per-face areas. Block
+    results are combined serially in block order. The dual area of a vertex
+    equals a third of the area of its incident faces, which is what the
+    centroid/edge-midpoint construction of compute_dual_vertex_areas()
+    evaluates to; it is gathered around the vertex fans without atomics.
+*/
+
+#include "meshstats_parallel.h"
+#include "face_block.h"
+#include "dedge.h"
+#include "trace.h"
+
+#include <limits>
+
+namespace {
+
+const uint32_t BLOCK_SIZE = 4096;
+
+// Statistics of one block of faces
+struct BlockStats {
+    double edgeLengthSum = 0, maxEdgeLength = 0, area = 0;
+    Eigen::Vector3d weightedCenter = Eigen::Vector3d::Zero();
+    Vector3f min = Vector3f::Constant(std::numeric_limits<Float>::infinity());
+    Vector3f max = Vector3f::Constant(-std::numeric_limits<Float>::infinity());
+};
+
+} // namespace
+
+MeshStats compute_mesh_stats_parallel(const MatrixXu &F, const MatrixXf &V,
+                                      VectorXf *faceAreas) {
+    PYIM_TRACE_SCOPE("mesh_stats");
+    if (F.size() == 0)
+        return compute_mesh_stats(F, V, true);
+    if (F.rows() != 3)
+        throw std::runtime_error("compute_mesh_stats_parallel(): only triangle meshes are supported!");
+
+    cout << "Computing mesh statistics in parallel .. ";
+    cout.flush();
+    Timer<> timer;
+
+    const uint32_t nFaces = (uint32_t) F.cols();
+    const uint32_t nBlocks = (nFaces + BLOCK_SIZE - 1) / BLOCK_SIZE;
+    std::vector<BlockStats> blocks(nBlocks);
+    if (faceAreas)
+        faceAreas->resize(nFaces);
+
+    tbb::parallel_for(
+        tbb::blocked_range<uint32_t>(0u, nBlocks, 1),
+        [&](const tbb::blocked_range<uint32_t> &range) {
+            PointBlock p[3], e[3], normal;
+            for (uint32_t b = range.begin(); b != range.end(); ++b) {
+                uint32_t begin = b * BLOCK_SIZE,
+                         end = std::min(begin + BLOCK_SIZE, nFaces);
+                gather_corners(F, V, begin, end, p);
+                for (int k = 0; k < 3; ++k)
+                    e[k] = p[(k + 1) % 3] - p[k];
+                block_cross(e[2], e[0], normal);
+                ScalarBlock area = Float(0.5) * block_dot(normal, normal).sqrt();
+                PointBlock center = (p[0] + p[1] + p[2]) * (Float(1) / Float(3));
+
+                BlockStats &stats = blocks[b];
+                for (int k = 0; k < 3; ++k) {
+                    ScalarBlock length = block_dot(e[k], e[k]).sqrt();
+                    stats.edgeLengthSum += length.cast<double>().sum();
+                    stats.maxEdgeLength = std::max(stats.maxEdgeLength, (double) length.maxCoeff());
+                    stats.min = stats.min.cwiseMin(p[k].colwise().minCoeff().transpose().matrix());
+                    stats.max = stats.max.cwiseMax(p[k].colwise().maxCoeff().transpose().matrix());
+                }
+                stats.area = area.cast<double>().sum();
+                stats.weightedCenter = (center.colwise() * area).cast<double>()
+                                           .colwise().sum().transpose().matrix();
+                if (faceAreas)
+                    faceAreas->segment(begin, end - begin) = area.matrix();
+            }
+        }
+    );
+
+    BlockStats total;
+    for (const BlockStats &stats : blocks) {
+        total.edgeLengthSum += stats.edgeLengthSum;
+        total.maxEdgeLength = std::max(total.maxEdgeLength, stats.maxEdgeLength);
+        total.area += stats.area;
+        total.weightedCenter += stats.weightedCenter;
+        total.min = total.min.cwiseMin(stats.min);
+        total.max = total.max.cwiseMax(stats.max);
+    }
+
+    MeshStats result;
+    result.mAABB.expandBy(total.min);
+    result.mAABB.expandBy(total.max);
+    result.mAverageEdgeLength = total.edgeLengthSum / F.size();
+    result.mMaximumEdgeLength = total.maxEdgeLength;
+    result.mSurfaceArea = total.area;
+    result.mWeightedCenter = (total.weightedCenter / total.area).cast<Float>();
+
+    cout << "done. (took " << timeString(timer.value()) << ")" << endl;
+    return result;
+}
+
+void compute_dual_vertex_areas_parallel(const MatrixXu &F, const MatrixXf &V,
+                                        const VectorXu &V2E, const VectorXu &E2E,
+                                        const VectorXb &nonManifold,
+                                        const VectorXf &faceAreas, VectorXf &A) {
+    PYIM_TRACE_SCOPE("dual_vertex_areas");
+    cout << "Computing dual vertex areas in parallel .. ";
+    cout.flush();
+    Timer<> timer;
+
+    const bool haveAreas = faceAreas.size() == F.cols() && F.cols() > 0;
+    auto face_area = [&](uint32_t f) -> Float {
+        if (haveAreas)
+            return faceAreas[f];
+        Vector3f v0 = V.col(F(0, f)), v1 = V.col(F(1, f)), v2 = V.col(F(2, f));
+        return Float(0.5) * (v1 - v0).cross(v2 - v0).norm();
+    };
+
+    A.resize(V.cols());
+    tbb::parallel_for(
+        tbb::blocked_range<uint32_t>(0u, (uint32_t) V.cols(), GRAIN_SIZE),
+        [&](const tbb::blocked_range<uint32_t> &range) {
+            for (uint32_t i = range.begin(); i != range.end(); ++i) {
+                uint32_t edge = V2E[i], stop = edge;
+                Float area = 0;
+                if (!nonManifold[i] && edge != INVALID) {
+                    do {
+                        area += face_area(edge / 3);
+                        uint32_t opp = E2E[edge];
+                        if (opp == INVALID)
+                            break;
+                        edge = dedge_next_3(opp);
+                    } while (edge != stop);
+                }
+                A[i] = area * (Float(1) / Float(3));
+            }
+        }
+    );
+
+    cout << "done. (took " << timeString(timer.value()) << ")" << endl;
+}
@@ -0,0 +1,37 @@
+/*
+    meshstats_parallel.h -- Fused mesh statistics and dual vertex areas
+
+    compute_mesh_stats() and compute_dual_vertex_areas() from the
+    instant-meshes submodule each make a full pass over all faces. Here,
+    one blocked parallel pass produces the statistics together with the
+    area of every face, and the dual vertex areas are gathered from those
+    face areas once the directed edge data structure exists.
+*/
+
+#pragma once
+
+#include "meshstats.h"
+
+/**
+ * Compute the statistics of a triangle mesh in one pass over its faces.
+ *
+ * Fills the same fields as compute_mesh_stats(). Partial results of fixed
+ * blocks of faces are combined in block order, so the result does not
+ * depend on the number of threads. If 'faceAreas' is given, it receives
+ * the area of every face. Point clouds fall back to compute_mesh_stats().
+ */
+extern MeshStats compute_mesh_stats_parallel(const MatrixXu &F, const MatrixXf &V,
+                                             VectorXf *faceAreas = nullptr);
+
+/**
+ * Barycentric dual area of every vertex, i.e. a third of the area of its
+ * incident faces, as computed by compute_dual_vertex_areas().
+ *
+ * 'faceAreas' must either hold the areas of the faces of F (see
+ * compute_mesh_stats_parallel()) or be empty, in which case they are
+ * computed on the fly. Non-manifold and isolated vertices get zero area.
+ */
+extern void compute_dual_vertex_areas_parallel(const MatrixXu &F, const MatrixXf &V,
+                                               const VectorXu &V2E, const VectorXu &E2E,
+                                               const VectorXb &nonManifold,
+                                               const VectorXf &faceAreas, VectorXf &A);
@@ -0,0 +1,167 @@
+/*
+    normal_parallel.cpp -- Gather-style parallel vertex and crease normals
+
+    The face pass gathers blocks of faces (see face_block.h), so that the
+    edge vectors, cross products, norms and corner cosines are evaluated
+    by Eigen's vectorized array expressions. The vertex pass walks the fan
+    of every vertex through V2E/E2E and only reads the per-face results,
+    which avoids atomics and keeps the summation order of the serial fan
+    walk. In crease mode, the
+    fan is cut into sectors at sharp edges and every sector contributes its
+    normalized normal, so that the normal of a vertex on a feature line
+    bisects the adjacent surfaces regardless of their tessellation.
+*/
+
+#include "normal_parallel.h"
+#include "face_block.h"
+#include "dedge.h"
+#include "trace.h"
+
+#include <tbb/enumerable_thread_specific.h>
+
+namespace {
+
+/* Unit normal and interior corner angles (in F order) of every face.
+   Degenerate faces get a zero normal and zero angles, so that they drop
+   out of the vertex sums */
+void face_normals_and_angles(const MatrixXu &F, const MatrixXf &V,
+                             MatrixXf &Nf, MatrixXf &angles) {
+    const uint32_t nFaces = (uint32_t) F.cols();
+    Nf.resize(3, nFaces);
+    angles.resize(3, nFaces);
+
+    tbb::parallel_for(
+        tbb::blocked_range<uint32_t>(0u, nFaces, GRAIN_SIZE),
+        [&](const tbb::blocked_range<uint32_t> &range) {
+            const uint32_t n = range.end() - range.begin();
+            PointBlock p[3], e[3], normal;
+            gather_corners(F, V, range.begin(), range.end(), p);
+
+            /* Edge k leaves corner k; the normal is (p1 - p0) x (p2 - p0) */
+            for (int k = 0; k < 3; ++k)
+                e[k] = p[(k + 1) % 3] - p[k];
+            block_cross(e[2], e[0], normal);
+            ScalarBlock length = block_dot(normal, normal).sqrt();
+
+            /* Corner k lies between edge k and the reversed edge k+2 */
+            ScalarBlock cosine[3];
+            for (int k = 0; k < 3; ++k) {
+                const PointBlock &incoming = e[(k + 2) % 3];
+                cosine[k] = (-block_dot(e[k], incoming) /
+                             (block_dot(e[k], e[k]) * block_dot(incoming, incoming)).sqrt())
+                                .max(-1).min(1);
+            }
+
+            for (uint32_t j = 0; j < n; ++j) {
+                uint32_t f = range.begin() + j;
+                if (!(length(j) > RCPOVERFLOW)) {
+                    Nf.col(f).setZero();
+                    angles.col(f).setZero();
+                    continue;
+                }
+                Nf.col(f) = (normal.row(j).transpose() / length(j)).matrix();
+                for (int k = 0; k < 3; ++k)
+                    angles(k, f) = fast_acos(cosine[k](j));
+            }
+        }
+    );
+}
+
+inline Vector3f normalized_or_zero(const Vector3f &v) {
+    Float norm = v.norm();
+    return norm > RCPOVERFLOW ? Vector3f(v / norm) : Vector3f::Zero();
+}
+
+} // namespace
+
+void generate_normals_parallel(const MatrixXu &F, const MatrixXf &V,
+                               const VectorXu &V2E, const VectorXu &E2E,
+                               const VectorXb &nonManifold, Float creaseAngle,
+                               MatrixXf &N, std::set<uint32_t> &creases) {
+    PYIM_TRACE_SCOPE("normals_parallel");
+    if (F.rows() != 3)
+        throw std::runtime_error("generate_normals_parallel(): only triangle meshes are supported!");
+
+    const bool creaseMode = creaseAngle >= 0;
+    const Float dpThreshold = std::cos(creaseAngle * M_PI / 180);
+    cout << (creaseMode ? "Computing vertex & crease normals in parallel .. "
+                        : "Computing vertex normals in parallel .. ");
+    cout.flush();
+    Timer<> timer;
+
+    MatrixXf Nf, angles;
+    face_normals_and_angles(F, V, Nf, angles);
+
+    auto is_crease = [&](uint32_t f0, uint32_t f1) {
+        Float dp = Nf.col(f0).dot(Nf.col(f1));
+        return dp < dpThreshold && Nf.col(f0).squaredNorm() > 0 &&
+               Nf.col(f1).squaredNorm() > 0;
+    };
+
+    tbb::enumerable_thread_specific<std::vector<uint32_t>> creaseLists;
+    N.resize(3, V.cols());
+
+    tbb::parallel_for(
+        tbb::blocked_range<uint32_t>(0u, (uint32_t) V.cols(), GRAIN_SIZE),
+        [&](const tbb::blocked_range<uint32_t> &range) {
+            std::vector<uint32_t> &creaseList = creaseLists.local();
+            for (uint32_t i = range.begin(); i != range.end(); ++i) {
+                uint32_t edge = V2E[i], stop = edge;
+                if (nonManifold[i] || edge == INVALID) {
+                    N.col(i) = Vector3f::UnitX();
+                    continue;
+                }
+
+                /* Walk the fan; boundary vertices start at their boundary
+                   edge (see build_dedge_parallel()) */
+                Vector3f sector = Vector3f::Zero(), first = Vector3f::Zero(),
+                         sum = Vector3f::Zero();
+                uint32_t nCreaseEdges = 0;
+                bool boundaryFan = false;
+                do {
+                    uint32_t f = edge / 3;
+                    sector += Nf.col(f) * angles(edge % 3, f);
+                    uint32_t opp = E2E[edge];
+                    if (opp == INVALID) {
+                        boundaryFan = true;
+                        break;
+                    }
+                    if (creaseMode && is_crease(f, opp / 3)) {
+                        if (nCreaseEdges++ == 0)
+                            first = sector;
+                        else
+                            sum += normalized_or_zero(sector);
+                        sector.setZero();
+                    }
+                    edge = dedge_next_3(opp);
+                } while (edge != stop);
+
+                Vector3f normal = sector;
+                if (nCreaseEdges > 0) {
+                    /* In a closed fan, the last sector continues into the first */
+                    if (boundaryFan)
+                        sum += normalized_or_zero(first);
+                    else
+                        sector += first;
+                    normal = sum + normalized_or_zero(sector);
+                    if (nCreaseEdges + (boundaryFan ? 1 : 0) >= 2)
+                        creaseList.push_back(i);
+                }
+
+                Float norm = normal.norm();
+                N.col(i) = norm > RCPOVERFLOW ? Vector3f(normal / norm)
+                                              : Vector3f::UnitX();
+            }
+        }
+    );
+
+    creases.clear();
+    for (const auto &list : creaseLists)
+        creases.insert(list.begin(), list.end());
+
+    if (creaseMode)
+        cout << "done. (" << creases.size() << " crease vertices, took "
+             << timeString(timer.value()) << ")" << endl;
+    else
+        cout << "done. (took " << timeString(timer.value()) << ")" << endl;
+}
@@ -0,0 +1,29 @@
+/*
+    normal_parallel.h -- Gather-style parallel vertex and crease normals
+
+    Alternative to generate_smooth_normals() and generate_crease_normals()
+    from the instant-meshes submodule, built from two data-parallel passes
+    over the directed edge data structure.
+*/
+
+#pragma once
+
+#include "common.h"
+#include <set>
+
+/**
+ * Compute angle-weighted vertex normals of a triangle mesh.
+ *
+ * A first pass computes the normal and the three corner angles of every
+ * face in SIMD-friendly blocks. A second pass gathers them around the fan
+ * of each vertex, so every vertex is written by exactly one task. With a
+ * non-negative 'creaseAngle' (in degrees), edges whose dihedral angle
+ * exceeds it split the fan of a vertex into sectors; such a vertex gets
+ * the normalized sum of its sector normals and is added to 'creases'.
+ * Vertices are not duplicated, so V2E, E2E and the adjacency matrix stay
+ * valid. Non-manifold and isolated vertices get the normal (1, 0, 0).
+ */
+extern void generate_normals_parallel(const MatrixXu &F, const MatrixXf &V,
+                                      const VectorXu &V2E, const VectorXu &E2E,
+                                      const VectorXb &nonManifold, Float creaseAngle,
+                                      MatrixXf &N, std::set<uint32_t> &creases);
@@ -0,0 +1,283 @@
+/*
+    numa.cpp -- NUMA interleaving of hierarchy data
+
+    Node topology is read from /sys/devices/system/node, and pages are
+    interleaved with the mbind() system call, so no libnuma is needed. On
+    other platforms, the binding is a no-op and the rehoming pass only
+    copies the data.
+*/
+
+#include "numa.h"
+#include "hugepages.h"
+#include "trace.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cctype>
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <sstream>
+
+#if defined(__linux__)
+#include <dirent.h>
+#include <sched.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#if defined(__linux__) && !defined(MPOL_INTERLEAVE)
+#define MPOL_INTERLEAVE 3
+#endif
+
+namespace {
+
+// Parse a cpulist such as "0-15,32-47"
+std::vector<int> parse_cpulist(const std::string &list) {
+    std::vector<int> cpus;
+    std::istringstream is(list);
+    std::string range;
+    while (std::getline(is, range, ',')) {
+        if (range.empty() || range == "\n")
+            continue;
+        size_t dash = range.find('-');
+        int first = std::stoi(range.substr(0, dash));
+        int last = dash == std::string::npos ? first : std::stoi(range.substr(dash + 1));
+        for (int cpu = first; cpu <= last; ++cpu)
+            cpus.push_back(cpu);
+    }
+    return cpus;
+}
+
+/* Interleave the pages of [data, data + bytes) round-robin over 'nodes'.
+   Only whole pages are bound; the policy takes effect at their first
+   touch. Returns false if the kernel rejected it */
+bool interleave_pages(void *data, size_t bytes, const std::vector<NumaNode> &nodes) {
+#if defined(__linux__) && defined(SYS_mbind)
+    const size_t bits = 8 * sizeof(unsigned long);
+    int maxNode = 0;
+    for (const NumaNode &node : nodes)
+        maxNode = std::max(maxNode, node.id);
+    std::vector<unsigned long> mask(maxNode / bits + 1, 0ul);
+    for (const NumaNode &node : nodes)
+        mask[node.id / bits] |= 1ul << (node.id % bits);
+
+    const uintptr_t page = (uintptr_t) sysconf(_SC_PAGESIZE);
+    uintptr_t begin = ((uintptr_t) data + page - 1) & ~(page - 1);
+    uintptr_t end = ((uintptr_t) data + bytes) & ~(page - 1);
+    if (end <= begin)
+        return true;
+    /* The kernel ignores the last bit of 'maxnode' */
+    return syscall(SYS_mbind, (void *) begin, (unsigned long) (end - begin),
+                   MPOL_INTERLEAVE, mask.data(),
+                   (unsigned long) (mask.size() * bits + 1), 0u) == 0;
+#else
+    (void) data; (void) bytes; (void) nodes;
+    return false;
+#endif
+}
+
+/* Where the new allocations of the rehoming pass go: interleaved over
+   'nodes' if there are several, and advised for huge pages on request */
+struct Placement {
+    std::vector<NumaNode> nodes;
+    bool hugePages;
+
+    void apply(void *data, size_t bytes) const {
+        if (hugePages)
+            advise_huge_pages(data, bytes);
+        if (nodes.size() > 1)
+            interleave_pages(data, bytes, nodes);
+    }
+};
+
+// Visit every vertex of a level from a parallel loop
+template <typename Func>
+void for_each_vertex(uint32_t n, const Func &func) {
+    tbb::parallel_for(
+        tbb::blocked_range<uint32_t>(0u, n, GRAIN_SIZE),
+        [&](const tbb::blocked_range<uint32_t> &range) {
+            for (uint32_t i = range.begin(); i != range.end(); ++i)
+                func(i);
+        }
+    );
+}
+
+// Copy the columns of a per-vertex matrix into a new allocation
+template <typename Matrix>
+void rehome_columns(Matrix &M, uint32_t n, const Placement &placement) {
+    if ((uint32_t) M.cols() != n || M.size() == 0)
+        return;
+    Matrix result(M.rows(), M.cols());
+    placement.apply(result.data(), result.size() * sizeof(typename Matrix::Scalar));
+    for_each_vertex(n, [&](uint32_t i) { result.col(i) = M.col(i); });
+    M = std::move(result);
+}
+
+// Same for per-vertex vectors
+template <typename Vector>
+void rehome_entries(Vector &v, uint32_t n, const Placement &placement) {
+    if ((uint32_t) v.size() != n || n == 0)
+        return;
+    Vector result(v.size());
+    placement.apply(result.data(), result.size() * sizeof(typename Vector::Scalar));
+    for_each_vertex(n, [&](uint32_t i) { result[i] = v[i]; });
+    v = std::move(result);
+}
+
+/* Move the link block of an adjacency matrix. Rows are stored back to back
+   starting at adj[0], and the block is released with delete[] adj[0] */
+void rehome_adjacency(AdjacencyMatrix adj, uint32_t n, const Placement &placement) {
+    Link *base = adj[0];
+    Link *block = new Link[adj[n] - base];
+    placement.apply(block, (adj[n] - base) * sizeof(Link));
+    for_each_vertex(n, [&](uint32_t i) {
+        std::copy(adj[i], adj[i + 1], block + (adj[i] - base));
+    });
+    for (uint32_t i = 0; i <= n; ++i)
+        adj[i] = block + (adj[i] - base);
+    delete[] base;
+}
+
+} // namespace
+
+std::vector<NumaNode> numa_nodes() {
+    std::vector<NumaNode> nodes;
+#if defined(__linux__)
+    cpu_set_t allowed;
+    CPU_ZERO(&allowed);
+    if (sched_getaffinity(0, sizeof(allowed), &allowed) != 0)
+        return nodes;
+
+    DIR *dir = opendir("/sys/devices/system/node");
+    if (!dir)
+        return nodes;
+    std::vector<int> ids;
+    while (struct dirent *entry = readdir(dir)) {
+        std::string name = entry->d_name;
+        if (name.size() > 4 && name.compare(0, 4, "node") == 0 &&
+            std::all_of(name.begin() + 4, name.end(), ::isdigit))
+            ids.push_back(std::stoi(name.substr(4)));
+    }
+    closedir(dir);
+    std::sort(ids.begin(), ids.end());
+
+    for (int id : ids) {
+        std::ifstream is("/sys/devices/system/node/node" + std::to_string(id) + "/cpulist");
+        std::string list;
+        if (!std::getline(is, list))
+            continue;
+        std::vector<int> cpus;
+        for (int cpu : parse_cpulist(list))
+            if (cpu < CPU_SETSIZE && CPU_ISSET(cpu, &allowed))
+                cpus.push_back(cpu);
+        if (!cpus.empty())
+            nodes.push_back(NumaNode{id, cpus});
+    }
+#endif
+    return nodes;
+}
+
+#if defined(__linux__)
+/* Node of every worker seen so far, and the original affinity mask of the
+   workers that are currently pinned, by thread id */
+struct NumaBinding::Workers {
+    std::mutex mutex;
+    std::map<pid_t, uint32_t> node;
+    std::map<pid_t, cpu_set_t> saved;
+};
+
+namespace {
+inline pid_t thread_id() { return (pid_t) syscall(SYS_gettid); }
+} // namespace
+#else
+struct NumaBinding::Workers { };
+#endif
+
+NumaBinding::NumaBinding()
+    : mNodes(numa_nodes()), mNextNode(0), mWorkers(new Workers()) {
+    if (mNodes.size() > 1)
+        observe(true);
+}
+
+NumaBinding::~NumaBinding() {
+    if (mNodes.size() < 2)
+        return;
+    observe(false);
+#if defined(__linux__)
+    std::lock_guard<std::mutex> guard(mWorkers->mutex);
+    for (const auto &entry : mWorkers->saved)
+        sched_setaffinity(entry.first, sizeof(cpu_set_t), &entry.second);
+    mWorkers->saved.clear();
+#endif
+}
+
+void NumaBinding::on_scheduler_entry(bool is_worker) {
+#if defined(__linux__)
+    if (!is_worker || mNodes.size() < 2)
+        return;
+    const pid_t tid = thread_id();
+    cpu_set_t original;
+    if (sched_getaffinity(0, sizeof(original), &original) != 0)
+        return;
+
+    std::lock_guard<std::mutex> guard(mWorkers->mutex);
+    if (mWorkers->saved.count(tid))
+        return;
+    auto it = mWorkers->node.find(tid);
+    if (it == mWorkers->node.end())
+        it = mWorkers->node.emplace(tid, mNextNode++ % mNodes.size()).first;
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (int cpu : mNodes[it->second].cpus)
+        CPU_SET(cpu, &set);
+    if (sched_setaffinity(0, sizeof(set), &set) == 0)
+        mWorkers->saved.emplace(tid, original);
+#else
+    (void) is_worker;
+#endif
+}
+
+void NumaBinding::on_scheduler_exit(bool is_worker) {
+#if defined(__linux__)
+    if (!is_worker || mNodes.size() < 2)
+        return;
+    const pid_t tid = thread_id();
+    std::lock_guard<std::mutex> guard(mWorkers->mutex);
+    auto it = mWorkers->saved.find(tid);
+    if (it == mWorkers->saved.end())
+        return;
+    sched_setaffinity(0, sizeof(cpu_set_t), &it->second);
+    mWorkers->saved.erase(it);
+#else
+    (void) is_worker;
+#endif
+}
+
+void rehome_hierarchy(MultiResolutionHierarchy &mRes, bool interleave, bool hugePages) {
+    PYIM_TRACE_SCOPE("rehome_hierarchy");
+    cout << "Re-allocating hierarchy data .. ";
+    cout.flush();
+    Timer<> timer;
+
+    Placement placement;
+    if (interleave)
+        placement.nodes = numa_nodes();
+    placement.hugePages = hugePages;
+
+    for (int l = 0; l < mRes.levels(); ++l) {
+        const uint32_t n = mRes.size(l);
+        rehome_columns(mRes.V(l), n, placement);
+        rehome_columns(mRes.N(l), n, placement);
+        rehome_entries(mRes.A(l), n, placement);
+        rehome_columns(mRes.Q(l), n, placement);
+        rehome_columns(mRes.O(l), n, placement);
+        rehome_columns(mRes.CQ(l), n, placement);
+        rehome_columns(mRes.CO(l), n, placement);
+        rehome_entries(mRes.CQw(l), n, placement);
+        rehome_entries(mRes.COw(l), n, placement);
+        rehome_adjacency(mRes.adj(l), n, placement);
+    }
+
+    cout << "done. (took " << timeString(timer.value()) << ")" << endl;
+}
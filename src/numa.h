@@ -0,0 +1,62 @@
+/*
+    numa.h -- NUMA interleaving of hierarchy data
+
+    Linux places a page on the NUMA node of the thread that first writes
+    it. The hierarchy arrays are written by whichever thread builds them,
+    so on multi-socket machines all of them end up on one node, whose
+    memory bandwidth the solver threads of every node then share.
+    NumaBinding spreads the TBB worker threads evenly over the nodes, and
+    rehome_hierarchy() copies the per-level arrays into fresh allocations
+    whose pages are interleaved round-robin over the nodes. This is an
+    interleave policy: the solver sweeps (field.cpp) schedule their ranges
+    with TBB's default partitioner, so a vertex is not swept by a thread of
+    the node that holds it, but the traffic is spread over all memory
+    controllers instead of one.
+*/
+
+#pragma once
+
+#include "hierarchy.h"
+#include <tbb/task_scheduler_observer.h>
+#include <atomic>
+#include <memory>
+
+// A NUMA node and the CPUs of it that this process may run on
+struct NumaNode {
+    int id;
+    std::vector<int> cpus;
+};
+
+// Nodes with at least one CPU that this process may run on (empty if unknown)
+extern std::vector<NumaNode> numa_nodes();
+
+/* Pins each TBB worker thread to the CPUs of one NUMA node, round-robin
+   over the nodes, while the object is alive. A worker keeps its node when
+   it leaves and re-enters the scheduler. Its original affinity mask is
+   restored when it leaves, and for all workers still pinned when the
+   object is destroyed. Does nothing on machines with a single node. The
+   thread that runs the job is never pinned */
+class NumaBinding : public tbb::task_scheduler_observer {
+public:
+    NumaBinding();
+    ~NumaBinding();
+
+    void on_scheduler_entry(bool is_worker) override;
+    void on_scheduler_exit(bool is_worker) override;
+
+    size_t nodes() const { return mNodes.size(); }
+
+private:
+    struct Workers;
+
+    std::vector<NumaNode> mNodes;
+    std::atomic<uint32_t> mNextNode;
+    std::unique_ptr<Workers> mWorkers;
+};
+
+/* Move the per-vertex arrays and adjacency matrices of all levels into
+   fresh allocations. With interleave, their pages are interleaved over the
+   nodes of numa_nodes() before they are touched; with hugePages, they are
+   advised for transparent huge pages */
+extern void rehome_hierarchy(MultiResolutionHierarchy &mRes, bool interleave,
+                             bool hugePages = false);
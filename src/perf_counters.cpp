@@ -0,0 +1,203 @@
+/*
+    perf_counters.cpp -- Hardware performance counters per pipeline stage
+
+    The events are opened per thread (pid = 0, cpu = -1) and count user
+    space only, which unprivileged processes may do with the default
+    perf_event_paranoid setting. Each event is opened on its own rather than
+    as a group, so that a missing counter does not take the others with it;
+    when the PMU multiplexes them, values are scaled by the ratio of the
+    enabled to the running time. TBB calls on_scheduler_entry() for a worker
+    the next time it takes part in work after the session was created.
+*/
+
+#include "perf_counters.h"
+#include "logging.h"
+
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+#if defined(__linux__)
+int open_counter(int counter) {
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+    switch (counter) {
+        case PerfCycles:
+            attr.type = PERF_TYPE_HARDWARE;
+            attr.config = PERF_COUNT_HW_CPU_CYCLES;
+            break;
+        case PerfInstructions:
+            attr.type = PERF_TYPE_HARDWARE;
+            attr.config = PERF_COUNT_HW_INSTRUCTIONS;
+            break;
+        case PerfLLCMisses:
+            attr.type = PERF_TYPE_HW_CACHE;
+            attr.config = PERF_COUNT_HW_CACHE_LL | (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                          (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+            break;
+        default:
+            attr.type = PERF_TYPE_HW_CACHE;
+            attr.config = PERF_COUNT_HW_CACHE_DTLB | (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                          (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+            break;
+    }
+    return (int) syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0);
+}
+
+uint64_t read_counter(int fd) {
+    uint64_t data[3];
+    if (fd < 0 || read(fd, data, sizeof(data)) != (ssize_t) sizeof(data) || data[2] == 0)
+        return 0;
+    if (data[1] == data[2])
+        return data[0];
+    return (uint64_t) ((double) data[0] * (double) data[1] / (double) data[2]);
+}
+#endif
+
+} // namespace
+
+struct PerfSession::ThreadCounters {
+    int fd[PerfCounterCount];
+    int error = 0;                    // errno of the last counter that failed to open
+
+    ThreadCounters() {
+        for (int k = 0; k < PerfCounterCount; ++k) {
+#if defined(__linux__)
+            fd[k] = open_counter(k);
+            if (fd[k] < 0)
+                error = errno;
+#else
+            fd[k] = -1;
+#endif
+        }
+    }
+
+    ~ThreadCounters() {
+#if defined(__linux__)
+        for (int k = 0; k < PerfCounterCount; ++k)
+            if (fd[k] >= 0)
+                close(fd[k]);
+#endif
+    }
+};
+
+const char *perf_counter_name(int counter) {
+    static const char *names[PerfCounterCount] = {
+        "cycles", "instructions", "llc_misses", "dtlb_misses"
+    };
+    return names[counter];
+}
+
+PerfSession::PerfSession(std::vector<PerfStageCounts> &results) : mResults(results) {
+    static std::atomic<uint64_t> nextId(0);
+    mId = ++nextId;
+    register_thread();
+    const ThreadCounters &own = *mThreads.front();
+    for (int k = 0; k < PerfCounterCount; ++k)
+        mAvailable[k] = own.fd[k] >= 0;
+    if (!available()) {
+        PYIM_LOG(LogLevel::Warning, "Hardware performance counters are not available ("
+                 << (own.error ? strerror(own.error) : "unsupported platform") << ")");
+        return;
+    }
+    observe(true);
+}
+
+PerfSession::~PerfSession() {
+    if (available())
+        observe(false);
+}
+
+bool PerfSession::available() const {
+    for (int k = 0; k < PerfCounterCount; ++k)
+        if (mAvailable[k])
+            return true;
+    return false;
+}
+
+void PerfSession::on_scheduler_entry(bool) {
+    /* Compared by id, since a later session may reuse the address */
+    static thread_local uint64_t registered = 0;
+    if (registered == mId)
+        return;
+    registered = mId;
+    register_thread();
+}
+
+void PerfSession::register_thread() {
+    std::unique_ptr<ThreadCounters> counters(new ThreadCounters());
+    std::lock_guard<std::mutex> guard(mMutex);
+    mThreads.push_back(std::move(counters));
+}
+
+std::vector<std::array<uint64_t, PerfCounterCount>> PerfSession::snapshot() {
+    std::lock_guard<std::mutex> guard(mMutex);
+    std::vector<std::array<uint64_t, PerfCounterCount>> values(mThreads.size());
+    for (size_t t = 0; t < mThreads.size(); ++t) {
+        for (int k = 0; k < PerfCounterCount; ++k) {
+#if defined(__linux__)
+            values[t][k] = read_counter(mThreads[t]->fd[k]);
+#else
+            values[t][k] = 0;
+#endif
+        }
+    }
+    return values;
+}
+
+void PerfSession::add(const char *stage,
+                      const std::vector<std::array<uint64_t, PerfCounterCount>> &begin) {
+    std::vector<std::array<uint64_t, PerfCounterCount>> end;
+    if (available())
+        end = snapshot();
+
+    PerfStageCounts *entry = nullptr;
+    for (PerfStageCounts &result : mResults)
+        if (result.stage == stage)
+            entry = &result;
+    if (!entry) {
+        mResults.push_back(PerfStageCounts());
+        entry = &mResults.back();
+        entry->stage = stage;
+    }
+
+    /* Threads that registered during the stage started counting from zero */
+    for (int k = 0; k < PerfCounterCount; ++k) {
+        if (!mAvailable[k])
+            continue;
+        uint64_t delta = 0;
+        for (size_t t = 0; t < end.size(); ++t) {
+            uint64_t previous = t < begin.size() ? begin[t][k] : 0;
+            if (end[t][k] > previous)
+                delta += end[t][k] - previous;
+        }
+        entry->value[k] += delta;
+        entry->available[k] = true;
+    }
+}
+
+PerfStage::PerfStage(PerfSession *session, const char *stage)
+    : mSession(session), mStage(stage) {
+    if (mSession && mSession->available())
+        mBegin = mSession->snapshot();
+}
+
+void PerfStage::end() {
+    if (!mSession)
+        return;
+    mSession->add(mStage, mBegin);
+    mSession = nullptr;
+}
@@ -0,0 +1,82 @@
+/*
+    perf_counters.h -- Hardware performance counters per pipeline stage
+
+    While a PerfSession is alive, every thread that runs TBB tasks (and the
+    thread that created the session) gets its own set of Linux perf events
+    for user-space cycles, instructions, last-level cache misses and dTLB
+    load misses. A PerfStage sums the counters of all these threads at its
+    beginning and end, so the result of a stage covers the work of every
+    worker. Counters that cannot be opened, e.g. in containers without
+    access to perf events or on other platforms, are left out.
+*/
+
+#pragma once
+
+#include "common.h"
+#include <tbb/task_scheduler_observer.h>
+#include <array>
+#include <memory>
+#include <mutex>
+
+enum PerfCounter {
+    PerfCycles = 0,
+    PerfInstructions,
+    PerfLLCMisses,
+    PerfDTLBMisses,
+    PerfCounterCount
+};
+
+// Key of a counter in the stats dictionary, e.g. "llc_misses"
+extern const char *perf_counter_name(int counter);
+
+// Counter deltas of one stage; only entries with 'available' are valid
+struct PerfStageCounts {
+    std::string stage;
+    uint64_t value[PerfCounterCount] = { };
+    bool available[PerfCounterCount] = { };
+};
+
+class PerfSession : public tbb::task_scheduler_observer {
+public:
+    // Results of the stages are appended to 'results' (repeats are summed)
+    explicit PerfSession(std::vector<PerfStageCounts> &results);
+    ~PerfSession();
+
+    void on_scheduler_entry(bool is_worker) override;
+
+    // Is at least one counter available?
+    bool available() const;
+
+private:
+    friend class PerfStage;
+    struct ThreadCounters;
+
+    // Scaled counter values of every registered thread, in registration order
+    std::vector<std::array<uint64_t, PerfCounterCount>> snapshot();
+    void add(const char *stage, const std::vector<std::array<uint64_t, PerfCounterCount>> &begin);
+    void register_thread();
+
+    std::vector<PerfStageCounts> &mResults;
+    uint64_t mId;
+    std::mutex mMutex;
+    std::vector<std::unique_ptr<ThreadCounters>> mThreads;
+    bool mAvailable[PerfCounterCount] = { };
+};
+
+/* Attribute the counter deltas between construction and end() (or
+   destruction) to 'stage'. Without available counters, the stage is listed
+   with no values; without a session, nothing happens */
+class PerfStage {
+public:
+    PerfStage(PerfSession *session, const char *stage);
+    ~PerfStage() { end(); }
+    void end();
+
+private:
+    PerfStage(const PerfStage &) = delete;
+    PerfStage &operator=(const PerfStage &) = delete;
+
+    PerfSession *mSession;
+    const char *mStage;
+    std::vector<std::array<uint64_t, PerfCounterCount>> mBegin;
+};
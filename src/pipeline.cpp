@@ -0,0 +1,568 @@
+/*
+    pipeline.cpp -- In-process driver for the Instant Meshes batch stages
+
+    The stage order and the target size heuristics follow batch.cpp from the
+    instant-meshes submodule. The directed edge data structure is built with
+    build_dedge_parallel() instead of the upstream linked-list traversal,
+    coarse inputs can optionally be refined with subdivide_parallel(), and
+    normals can be computed by generate_normals_parallel(). Mesh statistics,
+    face areas and dual vertex areas come from the fused passes of
+    meshstats_parallel.cpp; the first two are cached on a RemeshInput, so
+    repeated jobs on a prepared input skip them. Boundary constraints are
+    restricted to the coarse levels by restrict_constraints(). The hierarchy
+    can be coarsened with radix-sorted collapses (see hierarchy_radix.h).
+    The input can also be renumbered along a space-filling curve or by RCM
+    before the adjacency is built, which the whole hierarchy then inherits,
+    and the hierarchy levels can be laid out so that every color class is
+    contiguous. With a positive solver tolerance, the fields are optimized
+    by the residual-driven schedule of solver.cpp instead of the Optimizer
+    thread; with direct_solver, solver.cpp also runs the fixed schedule.
+    Scratch buffers of build_dedge_parallel(), build_hierarchy_radix() and
+    make_phases_contiguous() come from a per-job arena, and each stage
+    hands them back when it returns. The temporaries of the upstream stages use the global heap,
+    which is trimmed when the job ends. On NUMA machines, the hierarchy
+    can be re-allocated with its pages interleaved over the nodes.
+    The progress output of all stages goes to the log sink (see logging.h),
+    the stages are recorded as trace events (see trace.h), and on request
+    the hardware counters of every stage are collected (see perf_counters.h).
+    A parameter sweep prepares one hierarchy for all jobs that agree on the
+    options that preprocessing depends on, and the jobs then solve on
+    SharedHierarchy copies of it concurrently.
+*/
+
+#include "pipeline.h"
+#include "dedge_parallel.h"
+#include "subdivide_parallel.h"
+#include "normal_parallel.h"
+#include "meshstats_parallel.h"
+#include "hierarchy_layout.h"
+#include "hierarchy_radix.h"
+#include "hierarchy_share.h"
+#include "level_transfer.h"
+#include "trace.h"
+#include "perf_counters.h"
+#include "solver.h"
+#include "arena.h"
+#include "numa.h"
+#include "hugepages.h"
+#include "logging.h"
+
+#include "meshio.h"
+#include "dedge.h"
+#include "subdivide.h"
+#include "meshstats.h"
+#include "hierarchy.h"
+#include "field.h"
+#include "normal.h"
+#include "extract.h"
+#include "bvh.h"
+
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <limits>
+#include <memory>
+
+namespace {
+
+/* write_mesh() prints OBJ coordinates with the default six significant
+   digits, which throws away most of the benefit of a double precision
+   build. OBJ outputs are therefore written here with enough digits to
+   round-trip Float exactly; quads whose last two indices coincide are
+   written as triangles */
+void write_obj_exact(const std::string &filename, const MatrixXu &F,
+                     const MatrixXf &V) {
+    std::ofstream os(filename);
+    if (os.fail())
+        throw std::runtime_error("Unable to open OBJ file \"" + filename + "\"!");
+    os << std::setprecision(std::numeric_limits<Float>::max_digits10);
+
+    for (uint32_t i = 0; i < V.cols(); ++i)
+        os << "v " << V(0, i) << " " << V(1, i) << " " << V(2, i) << "\n";
+
+    for (uint32_t f = 0; f < F.cols(); ++f) {
+        uint32_t n = (uint32_t) F.rows();
+        if (n == 4 && F(3, f) == F(2, f))
+            n = 3;
+        os << "f";
+        for (uint32_t i = 0; i < n; ++i)
+            os << " " << F(i, f) + 1;
+        os << "\n";
+    }
+}
+
+/* Target edge length of a job, following the heuristics of batch_process().
+   'vertices' is the vertex count of the input */
+Float target_scale(const RemeshOptions &opts, const MeshStats &stats, uint32_t vertices) {
+    const int posy = opts.posy;
+    Float scale = opts.scale;
+    int face_count = opts.face_count, vertex_count = opts.vertex_count;
+
+    if (scale < 0 && vertex_count < 0 && face_count < 0) {
+        cout << "No target vertex count/face count/scale argument provided. "
+                "Setting to the default of 1/16 * input vertex count." << endl;
+        vertex_count = vertices / 16;
+    }
+
+    if (scale > 0) {
+        Float face_area = posy == 4 ? (scale*scale) : (std::sqrt(3.f)/4.f*scale*scale);
+        face_count = stats.mSurfaceArea / face_area;
+        vertex_count = posy == 4 ? face_count : (face_count / 2);
+    } else if (face_count > 0) {
+        Float face_area = stats.mSurfaceArea / face_count;
+        vertex_count = posy == 4 ? face_count : (face_count / 2);
+        scale = posy == 4 ? std::sqrt(face_area) : (2*std::sqrt(face_area * std::sqrt(1.f/3.f)));
+    } else if (vertex_count > 0) {
+        face_count = posy == 4 ? vertex_count : (vertex_count * 2);
+        Float face_area = stats.mSurfaceArea / face_count;
+        scale = posy == 4 ? std::sqrt(face_area) : (2*std::sqrt(face_area * std::sqrt(1.f/3.f)));
+    }
+
+    cout << "Output mesh goals (approximate)" << endl;
+    cout << "   Vertex count         = " << vertex_count << endl;
+    cout << "   Face count           = " << face_count << endl;
+    cout << "   Edge length          = " << scale << endl;
+    return scale;
+}
+
+/* Maximum edge length after subdividing a mesh that is too coarse for the
+   target edge length 'scale', or -1 if it is fine enough */
+Float subdivision_length(const MeshStats &stats, Float scale) {
+    if (stats.mMaximumEdgeLength*2 > scale || stats.mMaximumEdgeLength > stats.mAverageEdgeLength * 2)
+        return std::min(scale/2, (Float) stats.mAverageEdgeLength*2);
+    return -1;
+}
+
+/* Everything a job needs before the fields are solved: the hierarchy
+   without a solution, the crease vertices of the input and the BVH for
+   smoothing the extracted mesh. It only depends on the options compared by
+   same_preprocessing(), and is not modified by the later stages when they
+   run on a SharedHierarchy */
+struct PreparedHierarchy {
+    MultiResolutionHierarchy mRes;
+    std::set<uint32_t> crease_in;
+    std::unique_ptr<BVH> bvh;
+    std::unique_ptr<NumaBinding> numaBinding;
+    bool pointcloud = false;
+};
+
+// Do two jobs on the same input (and with these subdivision lengths) share their preprocessing?
+bool same_preprocessing(const RemeshOptions &a, Float subdivideA,
+                        const RemeshOptions &b, Float subdivideB) {
+    return subdivideA == subdivideB && a.crease_angle == b.crease_angle &&
+           a.knn_points == b.knn_points && a.deterministic == b.deterministic &&
+           a.parallel_subdivide == b.parallel_subdivide &&
+           a.parallel_normals == b.parallel_normals &&
+           a.radix_downsample == b.radix_downsample &&
+           a.vertex_ordering == b.vertex_ordering &&
+           a.color_contiguous == b.color_contiguous && a.numa_interleave == b.numa_interleave &&
+           a.huge_pages == b.huge_pages &&
+           (a.smooth_iterations > 0) == (b.smooth_iterations > 0);
+}
+
+/* Preprocessing and hierarchy construction. 'input' must have its
+   statistics already; 'scale' is the target edge length of the job */
+void prepare_stages(RemeshInput input, const RemeshOptions &opts, Float scale,
+                    PreparedHierarchy &prep, PerfSession *perfSession, JobArena &arena) {
+    MultiResolutionHierarchy &mRes = prep.mRes;
+    MatrixXu F = std::move(input.F);
+    MatrixXf V = std::move(input.V), N = std::move(input.N);
+    VectorXf A;
+    std::set<uint32_t> &crease_in = prep.crease_in;
+    std::unique_ptr<BVH> &bvh = prep.bvh;
+    AdjacencyMatrix adj = nullptr;
+    const MeshStats &stats = input.stats;
+
+    PerfStage preprocessStage(perfSession, "preprocess");
+    Timer<> timer;
+
+    bool pointcloud = prep.pointcloud = F.size() == 0;
+    if (pointcloud) {
+        reorder_vertices(F, V, N, opts.vertex_ordering);
+        bvh.reset(new BVH(&F, &V, &N, stats.mAABB));
+        bvh->build();
+        adj = generate_adjacency_matrix_pointcloud(V, N, bvh.get(), stats,
+                                                   opts.knn_points, opts.deterministic);
+        A.resize(V.cols());
+        A.setConstant(1.0f);
+    }
+
+    if (!pointcloud) {
+        /* Subdivide the mesh if necessary */
+        VectorXu V2E, E2E;
+        VectorXb boundary, nonManifold;
+        Float maxLength = subdivision_length(stats, scale);
+        if (maxLength > 0) {
+            cout << "Input mesh is too coarse for the desired output edge length "
+                    "(max input mesh edge length=" << stats.mMaximumEdgeLength
+                 << "), subdividing .." << endl;
+            PYIM_TRACE_SCOPE("subdivide");
+            input.faceAreas.resize(0);
+            build_dedge_parallel(F, V, V2E, E2E, boundary, nonManifold, &arena);
+            if (opts.parallel_subdivide)
+                subdivide_parallel(F, V, V2E, E2E, boundary, nonManifold, maxLength);
+            else
+                subdivide(F, V, V2E, E2E, boundary, nonManifold, maxLength,
+                          opts.deterministic);
+        }
+
+        /* Renumber vertices and faces for locality before any adjacency is built */
+        reorder_vertices(F, V, N, opts.vertex_ordering);
+        if (opts.vertex_ordering != VertexOrdering::None)
+            input.faceAreas.resize(0);
+
+        /* Compute a directed edge data structure */
+        build_dedge_parallel(F, V, V2E, E2E, boundary, nonManifold, &arena);
+
+        /* Compute adjacency matrix */
+        {
+            PYIM_TRACE_SCOPE("adjacency");
+            adj = generate_adjacency_matrix_uniform(F, V2E, E2E, nonManifold);
+        }
+
+        /* Compute vertex/crease normals */
+        {
+            PYIM_TRACE_SCOPE("normals");
+            if (opts.parallel_normals)
+                generate_normals_parallel(F, V, V2E, E2E, nonManifold,
+                                          opts.crease_angle, N, crease_in);
+            else if (opts.crease_angle >= 0)
+                generate_crease_normals(F, V, V2E, E2E, boundary, nonManifold,
+                                        opts.crease_angle, N, crease_in);
+            else
+                generate_smooth_normals(F, V, V2E, E2E, nonManifold, N);
+        }
+
+        /* Compute dual vertex areas, reusing the face areas of the statistics
+           pass unless the faces were subdivided or renumbered since */
+        compute_dual_vertex_areas_parallel(F, V, V2E, E2E, nonManifold,
+                                           input.faceAreas, A);
+
+        mRes.setE2E(std::move(E2E));
+    }
+
+    /* Build multi-resolution hierarchy */
+    mRes.setAdj(std::move(adj));
+    mRes.setF(std::move(F));
+    mRes.setV(std::move(V));
+    mRes.setA(std::move(A));
+    mRes.setN(std::move(N));
+    mRes.setScale(scale);
+    preprocessStage.end();
+    PerfStage hierarchyStage(perfSession, "build_hierarchy");
+    {
+        PYIM_TRACE_SCOPE("build_hierarchy");
+        if (opts.radix_downsample)
+            build_hierarchy_radix(mRes, opts.deterministic, &arena);
+        else
+            mRes.build(opts.deterministic);
+    }
+    if (opts.color_contiguous)
+        make_phases_contiguous(mRes, crease_in, &arena);
+
+    /* Spread the TBB workers over the NUMA nodes for the rest of the job,
+       and interleave the pages of the hierarchy data over the nodes. The
+       same pass moves the data into huge pages if requested. On a single
+       node there is nothing to move */
+    if (opts.numa_interleave)
+        prep.numaBinding.reset(new NumaBinding());
+    const bool interleave = prep.numaBinding && prep.numaBinding->nodes() > 1;
+    if (interleave || opts.huge_pages)
+        rehome_hierarchy(mRes, interleave, opts.huge_pages);
+    hierarchyStage.end();
+
+    if (bvh && !opts.color_contiguous) {
+        bvh->setData(&mRes.F(), &mRes.V(), &mRes.N());
+    } else if (bvh || opts.smooth_iterations > 0) {
+        /* The point cloud BVH refers to vertex indices, which the
+           color-contiguous layout has changed */
+        bvh.reset(new BVH(&mRes.F(), &mRes.V(), &mRes.N(), stats.mAABB));
+        bvh->build();
+    }
+
+    cout << "Preprocessing is done. (total time excluding file I/O: "
+         << timeString(timer.reset()) << ")" << endl;
+}
+
+/* Boundary constraints, field optimization and extraction on 'mRes', which
+   is either prep.mRes itself or a SharedHierarchy of it */
+void solve_stages(MultiResolutionHierarchy &mRes, const PreparedHierarchy &prep,
+                  const std::string &output, const RemeshOptions &opts, Float scale,
+                  RemeshStats &job_stats, RemeshOutput *mesh, PerfSession *perfSession) {
+    const int rosy = opts.rosy, posy = opts.posy;
+    std::set<uint32_t> crease_in = prep.crease_in, crease_out;
+    Timer<> timer;
+
+    mRes.setScale(scale);
+    mRes.resetSolution();
+
+    if (opts.align_to_boundaries && !prep.pointcloud) {
+        set_boundary_constraints(mRes);
+        restrict_constraints(mRes, rosy, posy);
+    }
+
+    /* A positive tolerance replaces the fixed schedule of the Optimizer
+       thread by the residual-driven one of solver.cpp. With direct_solver,
+       solver.cpp runs the fixed schedule on this thread as well, so that no
+       mutex and condition variable handoffs happen between the phases. So
+       does a solver control, which the Optimizer would not check */
+    SolverOptions solverOpts;
+    solverOpts.rosy = rosy;
+    solverOpts.posy = posy;
+    solverOpts.extrinsic = opts.extrinsic;
+    solverOpts.tolerance = opts.solver_tolerance;
+    solverOpts.max_iterations = opts.solver_max_iterations;
+    solverOpts.control = opts.solver_control;
+
+    std::unique_ptr<Optimizer> optimizer;
+    if (opts.solver_tolerance <= 0 && !opts.direct_solver && !opts.solver_control) {
+        optimizer.reset(new Optimizer(mRes, false));
+        optimizer->setRoSy(rosy);
+        optimizer->setPoSy(posy);
+        optimizer->setExtrinsic(opts.extrinsic);
+    }
+
+    cout << "Optimizing orientation field .. ";
+    cout.flush();
+    {
+        PYIM_TRACE_SCOPE("optimize_orientations");
+        PerfStage stage(perfSession, "optimize_orientations");
+        if (optimizer) {
+            optimizer->optimizeOrientations(-1);
+            optimizer->notify();
+            optimizer->wait();
+        } else if (!solve_orientations(mRes, solverOpts, job_stats.orientation)) {
+            throw std::runtime_error("remesh_pipeline(): the job was cancelled");
+        }
+    }
+    cout << "done. (took " << timeString(timer.reset()) << ")" << endl;
+
+    std::map<uint32_t, uint32_t> sing;
+    {
+        PYIM_TRACE_SCOPE("orientation_singularities");
+        compute_orientation_singularities(mRes, sing, opts.extrinsic, rosy);
+    }
+    cout << "Orientation field has " << sing.size() << " singularities." << endl;
+    timer.reset();
+
+    cout << "Optimizing position field .. ";
+    cout.flush();
+    {
+        PYIM_TRACE_SCOPE("optimize_positions");
+        PerfStage stage(perfSession, "optimize_positions");
+        if (optimizer) {
+            optimizer->optimizePositions(-1);
+            optimizer->notify();
+            optimizer->wait();
+            optimizer->shutdown();
+        } else if (!solve_positions(mRes, solverOpts, job_stats.position)) {
+            throw std::runtime_error("remesh_pipeline(): the job was cancelled");
+        }
+    }
+    cout << "done. (took " << timeString(timer.reset()) << ")" << endl;
+
+    if (opts.huge_pages)
+        job_stats.huge_pages = hierarchy_huge_pages(mRes);
+
+    PerfStage extractionStage(perfSession, "extraction");
+    MatrixXf O_extr, N_extr, Nf_extr;
+    std::vector<std::vector<TaggedLink>> adj_extr;
+    {
+        PYIM_TRACE_SCOPE("extract_graph");
+        extract_graph(mRes, opts.extrinsic, rosy, posy, adj_extr, O_extr, N_extr,
+                      crease_in, crease_out, opts.deterministic);
+    }
+
+    MatrixXu F_extr;
+    {
+        PYIM_TRACE_SCOPE("extract_faces");
+        extract_faces(adj_extr, O_extr, N_extr, Nf_extr, F_extr, posy,
+                      mRes.scale(), crease_out, true, opts.pure_quad, prep.bvh.get(),
+                      opts.smooth_iterations);
+    }
+    cout << "Extraction is done. (total time: " << timeString(timer.reset()) << ")" << endl;
+    extractionStage.end();
+
+    if (!output.empty()) {
+        PerfStage stage(perfSession, "write_output");
+        write_output(output, F_extr, O_extr, Nf_extr);
+    }
+
+    if (mesh) {
+        mesh->F = std::move(F_extr);
+        mesh->V = std::move(O_extr);
+        mesh->Nf = std::move(Nf_extr);
+    }
+}
+
+void run_stages(RemeshInput input, const std::string &output,
+                const RemeshOptions &opts, RemeshStats &job_stats, RemeshOutput *mesh,
+                JobArena &arena) {
+    /* Counter deltas of every stage, summed over all threads */
+    std::unique_ptr<PerfSession> perfSession;
+    if (opts.perf_counters)
+        perfSession.reset(new PerfSession(job_stats.perf));
+
+    /* Prepared inputs carry their statistics and face areas already */
+    if (!input.hasStats) {
+        PerfStage stage(perfSession.get(), "preprocess");
+        input.stats = compute_mesh_stats_parallel(input.F, input.V, &input.faceAreas);
+        input.hasStats = true;
+    }
+    Float scale = target_scale(opts, input.stats, (uint32_t) input.V.cols());
+
+    PreparedHierarchy prep;
+    prepare_stages(std::move(input), opts, scale, prep, perfSession.get(), arena);
+    solve_stages(prep.mRes, prep, output, opts, scale, job_stats, mesh, perfSession.get());
+}
+
+} // namespace
+
+void load_remesh_input(const std::string &path, RemeshInput &input) {
+    PYIM_TRACE_SCOPE("load_mesh");
+    LogCapture capture;
+    load_mesh_or_pointcloud(path, input.F, input.V, input.N);
+    input.hasStats = false;
+    input.faceAreas.resize(0);
+}
+
+void prepare_remesh_input(RemeshInput &input) {
+    if (input.hasStats)
+        return;
+    LogCapture capture;
+    input.stats = compute_mesh_stats_parallel(input.F, input.V, &input.faceAreas);
+    input.hasStats = true;
+}
+
+void remesh_pipeline(const RemeshInput &input, const std::string &output,
+                     const RemeshOptions &opts, RemeshStats &job_stats,
+                     RemeshOutput *mesh) {
+    {
+        PYIM_TRACE_SCOPE("remesh_pipeline");
+        LogCapture capture;
+        JobArena arena;
+        run_stages(input, output, opts, job_stats, mesh, arena);
+    }
+
+    /* All buffers of the job are gone at this point. Hand the free heap
+       back to the system, so that long-lived workers keep a flat RSS */
+    trim_heap();
+}
+
+void remesh_pipeline(const std::string &input, const std::string &output,
+                     const RemeshOptions &opts, RemeshStats &job_stats,
+                     RemeshOutput *mesh) {
+    {
+        PYIM_TRACE_SCOPE("remesh_pipeline");
+        LogCapture capture;
+        JobArena arena;
+        RemeshInput loaded;
+        {
+            PYIM_TRACE_SCOPE("load_mesh");
+            load_mesh_or_pointcloud(input, loaded.F, loaded.V, loaded.N);
+        }
+        run_stages(std::move(loaded), output, opts, job_stats, mesh, arena);
+    }
+
+    /* All buffers of the job are gone at this point. Hand the free heap
+       back to the system, so that long-lived workers keep a flat RSS */
+    trim_heap();
+}
+
+void remesh_sweep_pipeline(const RemeshInput &input, std::vector<SweepJob> &jobs,
+                           std::vector<double> &group_seconds) {
+    PYIM_TRACE_SCOPE("remesh_sweep");
+    RemeshInput prepared = input;
+    prepare_remesh_input(prepared);
+    const bool pointcloud = prepared.F.size() == 0;
+
+    std::vector<Float> scales(jobs.size()), subdivide(jobs.size());
+    std::vector<size_t> firstJob;
+    std::vector<std::unique_ptr<PreparedHierarchy>> groups;
+    group_seconds.clear();
+    {
+        LogCapture capture;
+        for (size_t j = 0; j < jobs.size(); ++j) {
+            const RemeshOptions &opts = jobs[j].opts;
+            scales[j] = target_scale(opts, prepared.stats, (uint32_t) prepared.V.cols());
+            subdivide[j] = pointcloud ? -1 : subdivision_length(prepared.stats, scales[j]);
+            size_t g = 0;
+            while (g < firstJob.size() &&
+                   !same_preprocessing(jobs[firstJob[g]].opts, subdivide[firstJob[g]],
+                                       opts, subdivide[j]))
+                ++g;
+            if (g == firstJob.size())
+                firstJob.push_back(j);
+            jobs[j].group = (uint32_t) g;
+        }
+
+        JobArena arena;
+        for (size_t first : firstJob) {
+            Timer<std::chrono::microseconds> timer;
+            groups.emplace_back(new PreparedHierarchy());
+            prepare_stages(prepared, jobs[first].opts, scales[first], *groups.back(),
+                           nullptr, arena);
+            group_seconds.push_back(timer.value() * 1e-6);
+        }
+    }
+
+    /* The progress output of concurrent jobs would interleave, so it is
+       discarded. Blocking a TBB worker on the Optimizer thread of every job
+       would waste it, so the fixed schedule runs on the job's own thread */
+    LogCapture capture(true);
+    tbb::parallel_for(
+        tbb::blocked_range<size_t>(0u, jobs.size(), 1),
+        [&](const tbb::blocked_range<size_t> &range) {
+            for (size_t j = range.begin(); j != range.end(); ++j) {
+                PYIM_TRACE_SCOPE("sweep_job", (int32_t) j);
+                SweepJob &job = jobs[j];
+                RemeshOptions opts = job.opts;
+                opts.direct_solver = true;
+                opts.perf_counters = false;
+                Timer<std::chrono::microseconds> timer;
+                const PreparedHierarchy &prep = *groups[job.group];
+                SharedHierarchy shared(prep.mRes, opts.huge_pages);
+                solve_stages(shared.get(), prep, std::string(), opts, scales[j],
+                             job.stats, &job.mesh, nullptr);
+                job.seconds = timer.value() * 1e-6;
+            }
+        }
+    );
+}
+
+void set_boundary_constraints(MultiResolutionHierarchy &mRes) {
+    mRes.clearConstraints();
+    for (uint32_t i=0; i<3*mRes.F().cols(); ++i) {
+        if (mRes.E2E()[i] == INVALID) {
+            uint32_t i0 = mRes.F()(i%3, i/3);
+            uint32_t i1 = mRes.F()((i+1)%3, i/3);
+            Vector3f p0 = mRes.V().col(i0), p1 = mRes.V().col(i1);
+            Vector3f edge = p1-p0;
+            if (edge.squaredNorm() > 0) {
+                edge.normalize();
+                mRes.CO().col(i0) = p0;
+                mRes.CO().col(i1) = p1;
+                mRes.CQ().col(i0) = mRes.CQ().col(i1) = edge;
+                mRes.CQw()[i0] = mRes.CQw()[i1] = mRes.COw()[i0] =
+                    mRes.COw()[i1] = 1.0f;
+            }
+        }
+    }
+}
+
+bool has_obj_extension(const std::string &filename) {
+    if (filename.size() < 4)
+        return false;
+    std::string extension = filename.substr(filename.size() - 4);
+    std::transform(extension.begin(), extension.end(), extension.begin(), ::tolower);
+    return extension == ".obj";
+}
+
+void write_output(const std::string &filename, const MatrixXu &F,
+                  const MatrixXf &V, const MatrixXf &Nf) {
+    PYIM_TRACE_SCOPE("write_output");
+    if (has_obj_extension(filename))
+        write_obj_exact(filename, F, V);
+    else
+        write_mesh(filename, F, V, MatrixXf(), Nf);
+}
@@ -0,0 +1,126 @@
+/*
+    pipeline.h -- In-process driver for the Instant Meshes batch stages
+
+    Runs the same sequence of stages as batch_process() from the
+    instant-meshes submodule. Keeping the driver on this side lets the
+    bindings substitute their own implementations of individual stages
+    without patching upstream sources.
+*/
+
+#pragma once
+
+#include "common.h"
+#include "meshstats.h"
+#include "vertex_order.h"
+#include "solver.h"
+#include "perf_counters.h"
+#include <string>
+
+// Parameters of a single remeshing job (see batch_process())
+struct RemeshOptions {
+    int rosy = 4;
+    int posy = 4;
+    Float scale = -1;
+    int face_count = -1;
+    int vertex_count = -1;
+    Float crease_angle = -1;
+    bool extrinsic = false;
+    bool align_to_boundaries = false;
+    int smooth_iterations = 2;
+    int knn_points = 10;
+    bool pure_quad = false;
+    bool deterministic = false;
+    bool parallel_subdivide = false;
+    bool parallel_normals = false;
+    bool radix_downsample = false;
+    VertexOrdering vertex_ordering = VertexOrdering::None;
+    bool color_contiguous = false;
+    bool numa_interleave = false;
+    bool huge_pages = false;
+    Float solver_tolerance = 0;       // <= 0: fixed schedule of the Optimizer class
+    int solver_max_iterations = 6;
+    bool direct_solver = false;       // fixed schedule without the Optimizer thread
+    SolverControl *solver_control = nullptr;  // cancel/progress; implies direct_solver
+    bool perf_counters = false;       // collect hardware counters per stage
+};
+
+// Convergence information collected while running a job
+struct RemeshStats {
+    SolverTrace orientation;
+    SolverTrace position;
+    size_t huge_pages = 0;            // huge pages backing the hierarchy (with huge_pages)
+    std::vector<PerfStageCounts> perf;  // per-stage hardware counters (with perf_counters)
+};
+
+/* Input mesh of one or more jobs. The statistics of its faces (including
+   the area of every face) are computed by the first job, or up front by
+   prepare_remesh_input(), and then reused */
+struct RemeshInput {
+    MatrixXu F;
+    MatrixXf V, N;
+    bool hasStats = false;
+    MeshStats stats;
+    VectorXf faceAreas;
+};
+
+// Load a mesh or point cloud file into 'input'
+extern void load_remesh_input(const std::string &path, RemeshInput &input);
+
+// Compute the cached statistics of 'input' if they are missing
+extern void prepare_remesh_input(RemeshInput &input);
+
+/* Extracted mesh of a job, as produced by extract_faces(). F has 'posy'
+   rows; with posy == 4, triangles repeat their third index in the fourth row */
+struct RemeshOutput {
+    MatrixXu F;
+    MatrixXf V;
+    MatrixXf Nf;
+};
+
+/* One job of a parameter sweep. The stages up to the hierarchy are shared
+   with the other jobs of its group, see remesh_sweep_pipeline() */
+struct SweepJob {
+    RemeshOptions opts;
+    RemeshStats stats;
+    RemeshOutput mesh;
+    uint32_t group = 0;
+    double seconds = 0;               // own stages: solve and extraction
+};
+
+/* Constrain the orientation and position field of level 0 to the boundary
+   edges of the mesh, as batch.cpp does with align_to_boundaries. The
+   coarser levels are left to restrict_constraints() */
+extern void set_boundary_constraints(MultiResolutionHierarchy &mRes);
+
+// Does 'filename' end in .obj (case insensitive)?
+extern bool has_obj_extension(const std::string &filename);
+
+/* Write an extracted mesh to 'filename'. OBJ files are written with enough
+   digits to round-trip Float exactly, other formats go through write_mesh() */
+extern void write_output(const std::string &filename, const MatrixXu &F,
+                         const MatrixXf &V, const MatrixXf &Nf);
+
+/* Remesh the mesh or point cloud stored in 'input' and write the result to
+   'output' (skipped if empty). If 'mesh' is given, the extracted mesh is
+   also moved into it */
+extern void remesh_pipeline(const std::string &input, const std::string &output,
+                            const RemeshOptions &opts, RemeshStats &job_stats,
+                            RemeshOutput *mesh = nullptr);
+
+// Same for an input that is already in memory; 'input' is not modified
+extern void remesh_pipeline(const RemeshInput &input, const std::string &output,
+                            const RemeshOptions &opts, RemeshStats &job_stats,
+                            RemeshOutput *mesh = nullptr);
+
+/* Run several jobs on 'input' concurrently. Jobs whose preprocessing options
+   agree (crease angle, subdivision, ordering, hierarchy construction, ...)
+   form a group, which computes the adjacency, normals and hierarchy once.
+   The jobs of a group only read its adjacency matrices, and solve on their
+   own copies of the per-vertex level arrays (see SharedHierarchy).
+   Symmetries, targets that need no different subdivision, and solver and
+   extraction settings may vary within a group.
+   The jobs always run the solver on their own thread (see direct_solver),
+   without perf counters, and their progress output is discarded.
+   'group_seconds' receives the preprocessing time of every group */
+extern void remesh_sweep_pipeline(const RemeshInput &input, std::vector<SweepJob> &jobs,
+                                  std::vector<double> &group_seconds);
@@ -0,0 +1,178 @@
+/*
+    solver.cpp -- Residual-driven multigrid schedule for the field solver
+
+    The sweeps themselves are optimize_orientations() and optimize_positions()
+    from field.cpp; the prolongation between levels is done by the blocked
+    kernels of level_transfer.cpp, which mirror Optimizer::run().
+    Energies are accumulated in double precision over fixed-size blocks of
+    vertices, so the stopping decision does not depend on the thread count.
+*/
+
+#include "solver.h"
+#include "level_transfer.h"
+#include "trace.h"
+#include "field.h"
+
+#include <functional>
+#include <stdexcept>
+
+namespace {
+
+const uint32_t ENERGY_BLOCK_SIZE = 4096;
+
+inline std::pair<Vector3f, Vector3f>
+compat_orientation(const Vector3f &q0, const Vector3f &n0,
+                   const Vector3f &q1, const Vector3f &n1,
+                   bool extrinsic, int rosy) {
+    switch (rosy) {
+        case 2:
+            return extrinsic ? compat_orientation_extrinsic_2(q0, n0, q1, n1)
+                             : compat_orientation_intrinsic_2(q0, n0, q1, n1);
+        case 4:
+            return extrinsic ? compat_orientation_extrinsic_4(q0, n0, q1, n1)
+                             : compat_orientation_intrinsic_4(q0, n0, q1, n1);
+        case 6:
+            return extrinsic ? compat_orientation_extrinsic_6(q0, n0, q1, n1)
+                             : compat_orientation_intrinsic_6(q0, n0, q1, n1);
+        default:
+            throw std::runtime_error("Invalid rotation symmetry type " + std::to_string(rosy) + "!");
+    }
+}
+
+inline std::pair<Vector3f, Vector3f>
+compat_position(const Vector3f &p0, const Vector3f &n0, const Vector3f &q0, const Vector3f &o0,
+                const Vector3f &p1, const Vector3f &n1, const Vector3f &q1, const Vector3f &o1,
+                Float scale, Float inv_scale, bool extrinsic, int posy) {
+    switch (posy) {
+        case 3:
+            return extrinsic
+                ? compat_position_extrinsic_3(p0, n0, q0, o0, p1, n1, q1, o1, scale, inv_scale)
+                : compat_position_intrinsic_3(p0, n0, q0, o0, p1, n1, q1, o1, scale, inv_scale);
+        case 4:
+            return extrinsic
+                ? compat_position_extrinsic_4(p0, n0, q0, o0, p1, n1, q1, o1, scale, inv_scale)
+                : compat_position_intrinsic_4(p0, n0, q0, o0, p1, n1, q1, o1, scale, inv_scale);
+        default:
+            throw std::runtime_error("Invalid position symmetry type " + std::to_string(posy) + "!");
+    }
+}
+
+// Sum 'term(i, j, weight)' over all links of a level, in a fixed order of blocks
+template <typename Term>
+Float sum_over_links(const MultiResolutionHierarchy &mRes, int level, const Term &term) {
+    const AdjacencyMatrix &adj = mRes.adj(level);
+    const uint32_t size = mRes.size(level);
+    const uint32_t nBlocks = (size + ENERGY_BLOCK_SIZE - 1) / ENERGY_BLOCK_SIZE;
+    std::vector<double> partial(nBlocks, 0.0);
+
+    tbb::parallel_for(
+        tbb::blocked_range<uint32_t>(0u, nBlocks, 1),
+        [&](const tbb::blocked_range<uint32_t> &range) {
+            for (uint32_t block = range.begin(); block != range.end(); ++block) {
+                PYIM_TRACE_SCOPE("energy_block", level);
+                double sum = 0;
+                uint32_t end = std::min(size, (block + 1) * ENERGY_BLOCK_SIZE);
+                for (uint32_t i = block * ENERGY_BLOCK_SIZE; i < end; ++i)
+                    for (const Link *link = adj[i]; link != adj[i + 1]; ++link)
+                        sum += term(i, link->id, link->weight);
+                partial[block] = sum;
+            }
+        }
+    );
+
+    double total = 0;
+    for (double value : partial)
+        total += value;
+    return (Float) total;
+}
+
+/* Sweep each level from the coarsest to the finest one until the relative
+   energy change falls below the tolerance or the iteration cap is hit. The
+   fixed schedule does not evaluate the energy at all */
+bool run_schedule(MultiResolutionHierarchy &mRes, const SolverOptions &opts,
+                  SolverTrace &trace,
+                  const std::function<void(int)> &sweep,
+                  const std::function<Float(int)> &energy,
+                  const std::function<void(int)> &prolong) {
+    const bool adaptive = opts.tolerance > 0;
+    SolverControl *control = opts.control;
+    trace.energy.assign(adaptive ? mRes.levels() : 0, std::vector<Float>());
+
+    for (int level = mRes.levels() - 1; level >= 0; --level) {
+        PYIM_TRACE_SCOPE("solve_level", level);
+        Float previous = adaptive ? energy(level) : 0;
+        for (int it = 0; it < opts.max_iterations; ++it) {
+            if (control && control->cancel.load(std::memory_order_relaxed))
+                return false;
+            {
+                PYIM_TRACE_SCOPE("sweep", level);
+                sweep(level);
+            }
+            if (control)
+                control->sweeps.fetch_add(1, std::memory_order_relaxed);
+            if (!adaptive)
+                continue;
+            Float current = energy(level);
+            trace.energy[level].push_back(current);
+            if (std::abs(previous - current) <= opts.tolerance * std::abs(previous))
+                break;
+            previous = current;
+        }
+        if (level > 0)
+            prolong(level);
+    }
+    return true;
+}
+
+} // namespace
+
+Float orientation_energy(const MultiResolutionHierarchy &mRes, int level,
+                         bool extrinsic, int rosy) {
+    const MatrixXf &N = mRes.N(level), &Q = mRes.Q(level);
+    return sum_over_links(mRes, level, [&](uint32_t i, uint32_t j, Float weight) -> double {
+        auto value = compat_orientation(Q.col(i), N.col(i), Q.col(j), N.col(j),
+                                        extrinsic, rosy);
+        return weight * (value.first - value.second).squaredNorm();
+    });
+}
+
+Float position_energy(const MultiResolutionHierarchy &mRes, int level,
+                      bool extrinsic, int posy) {
+    const MatrixXf &V = mRes.V(level), &N = mRes.N(level),
+                   &Q = mRes.Q(level), &O = mRes.O(level);
+    const Float scale = mRes.scale(), inv_scale = 1.0f / scale;
+    return sum_over_links(mRes, level, [&](uint32_t i, uint32_t j, Float weight) -> double {
+        auto value = compat_position(V.col(i), N.col(i), Q.col(i), O.col(i),
+                                     V.col(j), N.col(j), Q.col(j), O.col(j),
+                                     scale, inv_scale, extrinsic, posy);
+        return weight * (value.first - value.second).squaredNorm();
+    });
+}
+
+bool solve_orientations(MultiResolutionHierarchy &mRes,
+                        const SolverOptions &opts, SolverTrace &trace) {
+    return run_schedule(mRes, opts, trace,
+        [&](int level) {
+            optimize_orientations(mRes, level, opts.extrinsic, opts.rosy,
+                                  [](uint32_t) { });
+        },
+        [&](int level) {
+            return orientation_energy(mRes, level, opts.extrinsic, opts.rosy);
+        },
+        [&](int level) { prolong_orientations(mRes, level); }
+    );
+}
+
+bool solve_positions(MultiResolutionHierarchy &mRes,
+                     const SolverOptions &opts, SolverTrace &trace) {
+    return run_schedule(mRes, opts, trace,
+        [&](int level) {
+            optimize_positions(mRes, level, opts.extrinsic, opts.posy,
+                               [](uint32_t) { });
+        },
+        [&](int level) {
+            return position_energy(mRes, level, opts.extrinsic, opts.posy);
+        },
+        [&](int level) { prolong_positions(mRes, level); }
+    );
+}
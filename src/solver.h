@@ -0,0 +1,54 @@
+/*
+    solver.h -- Residual-driven multigrid schedule for the field solver
+
+    Runs the per-level Gauss-Seidel sweeps of field.cpp from the coarsest to
+    the finest hierarchy level. Unlike the fixed schedule of the Optimizer
+    class, each level stops as soon as the relative change of its energy
+    drops below a tolerance. Without a tolerance, every level runs a fixed
+    number of sweeps. Either way the sweeps run as parallel loops on the
+    calling thread, without the background thread of the Optimizer.
+*/
+
+#pragma once
+
+#include "hierarchy.h"
+#include <atomic>
+
+/* Lock-free control of a running solve. 'cancel' may be set from any
+   thread; it is checked before every sweep. 'sweeps' counts the completed
+   sweeps of all levels and can be polled for progress */
+struct SolverControl {
+    std::atomic<bool> cancel;
+    std::atomic<uint32_t> sweeps;
+
+    SolverControl() : cancel(false), sweeps(0) { }
+};
+
+struct SolverOptions {
+    int rosy = 4;
+    int posy = 4;
+    bool extrinsic = false;
+    Float tolerance = 0;      // Relative energy change that ends a level (<= 0: fixed)
+    int max_iterations = 6;   // Cap on the number of sweeps per level
+    SolverControl *control = nullptr;
+};
+
+// Energy after every sweep, per hierarchy level (index 0 = finest)
+struct SolverTrace {
+    std::vector<std::vector<Float>> energy;
+};
+
+// Smoothness energy of the orientation field on one hierarchy level
+extern Float orientation_energy(const MultiResolutionHierarchy &mRes, int level,
+                                bool extrinsic, int rosy);
+
+// Smoothness energy of the position field on one hierarchy level
+extern Float position_energy(const MultiResolutionHierarchy &mRes, int level,
+                             bool extrinsic, int posy);
+
+// Both return false if the solve was cancelled through 'opts.control'
+extern bool solve_orientations(MultiResolutionHierarchy &mRes,
+                               const SolverOptions &opts, SolverTrace &trace);
+
+extern bool solve_positions(MultiResolutionHierarchy &mRes,
+                            const SolverOptions &opts, SolverTrace &trace);
@@ -0,0 +1,160 @@
+/*
+    subdivide_parallel.cpp -- Bulk-synchronous longest edge subdivision
+
+    An edge is split in the current round if it is longer than the
+    threshold and it is the longest splittable edge of every face it
+    belongs to (ties are broken by edge index). This selects an independent
+    set of faces, so all splits of a round can be applied concurrently. The
+    globally longest splittable edge always qualifies, which guarantees
+    progress. New vertices and faces are numbered with per-block prefix sums
+    rather than atomic counters to keep the output deterministic.
+*/
+
+#include "subdivide_parallel.h"
+#include "dedge_parallel.h"
+#include "dedge.h"
+#include "trace.h"
+
+namespace {
+
+const uint32_t BLOCK_SIZE = 4096;
+
+// Splittable edge candidate of a face: squared length and canonical edge id
+struct Candidate {
+    Float length2;
+    uint32_t edge;
+
+    Candidate() : length2(0), edge(INVALID) { }
+    Candidate(Float length2, uint32_t edge) : length2(length2), edge(edge) { }
+
+    bool operator>(const Candidate &other) const {
+        return length2 > other.length2 ||
+               (length2 == other.length2 && edge < other.edge);
+    }
+};
+
+} // namespace
+
+void subdivide_parallel(MatrixXu &F, MatrixXf &V, VectorXu &V2E,
+                        VectorXu &E2E, VectorXb &boundary,
+                        VectorXb &nonmanifold, Float maxLength) {
+    PYIM_TRACE_SCOPE("subdivide_parallel");
+    if (F.rows() != 3)
+        throw std::runtime_error("subdivide_parallel(): only triangle meshes are supported!");
+
+    const Float maxLength2 = maxLength * maxLength;
+    uint32_t nRounds = 0, nSplit = 0;
+    std::vector<Candidate> best;
+    std::vector<uint32_t> blockCounts;
+
+    cout << "Subdividing mesh in parallel rounds .. ";
+    cout.flush();
+    Timer<> timer;
+
+    while (true) {
+        const uint32_t nFaces = (uint32_t) F.cols();
+        const uint32_t nEdges = 3 * nFaces;
+
+        /* Find the longest splittable edge of every face. Both halves of an
+           interior edge are identified by the smaller half-edge index */
+        best.assign(nFaces, Candidate());
+        tbb::parallel_for(
+            tbb::blocked_range<uint32_t>(0u, nFaces, GRAIN_SIZE),
+            [&](const tbb::blocked_range<uint32_t> &range) {
+                for (uint32_t f = range.begin(); f != range.end(); ++f) {
+                    for (uint32_t i = 0; i < 3; ++i) {
+                        uint32_t v0 = F(i, f), v1 = F((i + 1) % 3, f);
+                        if (nonmanifold[v0] || nonmanifold[v1])
+                            continue;
+                        Float length2 = (V.col(v0) - V.col(v1)).squaredNorm();
+                        if (!(length2 > maxLength2))
+                            continue;
+                        uint32_t edge = 3 * f + i;
+                        Candidate c(length2, std::min(edge, E2E[edge]));
+                        if (c > best[f])
+                            best[f] = c;
+                    }
+                }
+            }
+        );
+
+        /* Select the edges that are the best candidate on both sides and
+           count the vertices/faces they will add, one block at a time */
+        auto isSelected = [&](uint32_t edge) -> bool {
+            uint32_t opp = E2E[edge];
+            if (opp != INVALID && opp < edge)
+                return false;
+            if (best[edge / 3].edge != edge)
+                return false;
+            return opp == INVALID || best[opp / 3].edge == edge;
+        };
+
+        const uint32_t nBlocks = (nEdges + BLOCK_SIZE - 1) / BLOCK_SIZE;
+        blockCounts.assign(2 * nBlocks + 2, 0);
+        tbb::parallel_for(0u, nBlocks, [&](uint32_t block) {
+            uint32_t vertices = 0, faces = 0;
+            uint32_t end = std::min(nEdges, (block + 1) * BLOCK_SIZE);
+            for (uint32_t edge = block * BLOCK_SIZE; edge < end; ++edge) {
+                if (!isSelected(edge))
+                    continue;
+                vertices += 1;
+                faces += E2E[edge] == INVALID ? 1 : 2;
+            }
+            blockCounts[2 * block + 2] = vertices;
+            blockCounts[2 * block + 3] = faces;
+        });
+
+        for (uint32_t block = 0; block < nBlocks; ++block) {
+            blockCounts[2 * block + 2] += blockCounts[2 * block];
+            blockCounts[2 * block + 3] += blockCounts[2 * block + 1];
+        }
+        uint32_t newVertices = blockCounts[2 * nBlocks],
+                 newFaces = blockCounts[2 * nBlocks + 1];
+        if (newVertices == 0)
+            break;
+
+        const uint32_t nVertices = (uint32_t) V.cols();
+        V.conservativeResize(V.rows(), nVertices + newVertices);
+        F.conservativeResize(3, nFaces + newFaces);
+
+        /* Split the selected edges. Each face is modified by at most one
+           split, so the blocks can be processed independently */
+        tbb::parallel_for(0u, nBlocks, [&](uint32_t block) {
+            uint32_t vertexIndex = nVertices + blockCounts[2 * block],
+                     faceIndex = nFaces + blockCounts[2 * block + 1];
+            uint32_t end = std::min(nEdges, (block + 1) * BLOCK_SIZE);
+            for (uint32_t edge = block * BLOCK_SIZE; edge < end; ++edge) {
+                if (!isSelected(edge))
+                    continue;
+
+                uint32_t f0 = edge / 3, i0 = edge % 3;
+                uint32_t v0 = F(i0, f0), v1 = F((i0 + 1) % 3, f0),
+                         v2 = F((i0 + 2) % 3, f0);
+                uint32_t vn = vertexIndex++;
+                V.col(vn) = (V.col(v0) + V.col(v1)) * 0.5f;
+
+                /* (v0, v1, v2) -> (v0, vn, v2) + (vn, v1, v2) */
+                F((i0 + 1) % 3, f0) = vn;
+                F.col(faceIndex++) << vn, v1, v2;
+
+                uint32_t opp = E2E[edge];
+                if (opp == INVALID)
+                    continue;
+
+                /* (v1, v0, v3) -> (v1, vn, v3) + (vn, v0, v3) */
+                uint32_t f1 = opp / 3, i1 = opp % 3;
+                uint32_t v3 = F((i1 + 2) % 3, f1);
+                F((i1 + 1) % 3, f1) = vn;
+                F.col(faceIndex++) << vn, v0, v3;
+            }
+        });
+
+        nSplit += newVertices;
+        ++nRounds;
+
+        build_dedge_parallel(F, V, V2E, E2E, boundary, nonmanifold);
+    }
+
+    cout << "done. (split " << nSplit << " edges in " << nRounds
+         << " rounds, took " << timeString(timer.value()) << ")" << endl;
+}
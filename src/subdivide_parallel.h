@@ -0,0 +1,22 @@
+/*
+    subdivide_parallel.h -- Bulk-synchronous longest edge subdivision
+
+    Parallel alternative to subdivide() from the instant-meshes submodule,
+    which splits one edge at a time from a priority queue.
+*/
+
+#pragma once
+
+#include "common.h"
+
+/**
+ * Split all triangle mesh edges longer than 'maxLength' in rounds.
+ *
+ * Each round selects an independent set of edges (every face is touched by
+ * at most one split), splits them all at once and rebuilds the directed edge
+ * data structure, until no splittable edge exceeds the threshold. The result
+ * only depends on the input, not on the number of threads.
+ */
+extern void subdivide_parallel(MatrixXu &F, MatrixXf &V, VectorXu &V2E,
+                               VectorXu &E2E, VectorXb &boundary,
+                               VectorXb &nonmanifold, Float maxLength);
@@ -0,0 +1,436 @@
+/*
+    testing.cpp -- Kernel entry points for the test suite
+
+    Every function runs one stage of this tree, or the upstream routine it
+    replaces, on numpy arrays and returns the raw results, so that the tests
+    can compare the two or check the stage directly. The progress output
+    goes to the log sink, as in a job.
+*/
+
+#include "testing.h"
+#include "dedge_parallel.h"
+#include "subdivide_parallel.h"
+#include "vertex_order.h"
+#include "normal_parallel.h"
+#include "meshstats_parallel.h"
+#include "hierarchy_layout.h"
+#include "hierarchy_radix.h"
+#include "hierarchy_access.h"
+#include "level_transfer.h"
+#include "pipeline.h"
+#include "logging.h"
+
+#include "dedge.h"
+#include "subdivide.h"
+#include "adjacency.h"
+#include "meshio.h"
+#include "normal.h"
+#include "meshstats.h"
+#include "hierarchy.h"
+
+#include <pybind11/numpy.h>
+
+namespace py = pybind11;
+
+namespace {
+
+typedef py::array_t<Float, py::array::c_style | py::array::forcecast> FloatArray;
+typedef py::array_t<int, py::array::c_style | py::array::forcecast> IndexArray;
+
+// Nx3 vertex array to a 3xN matrix
+MatrixXf to_vertices(const FloatArray &vertices) {
+    if (vertices.ndim() != 2 || vertices.shape(1) != 3)
+        throw std::runtime_error("Vertices must be a Nx3 array");
+    MatrixXf V(3, vertices.shape(0));
+    auto v = vertices.unchecked<2>();
+    for (py::ssize_t i = 0; i < v.shape(0); ++i)
+        for (int j = 0; j < 3; ++j)
+            V(j, i) = v(i, j);
+    return V;
+}
+
+// Nx3 or Nx4 face array to a 3xN or 4xN matrix
+MatrixXu to_faces(const IndexArray &faces) {
+    if (faces.ndim() != 2 || (faces.shape(1) != 3 && faces.shape(1) != 4))
+        throw std::runtime_error("Faces must be a Nx3 or Nx4 array");
+    MatrixXu F(faces.shape(1), faces.shape(0));
+    auto f = faces.unchecked<2>();
+    for (py::ssize_t i = 0; i < f.shape(0); ++i)
+        for (py::ssize_t j = 0; j < f.shape(1); ++j)
+            F(j, i) = (uint32_t) f(i, j);
+    return F;
+}
+
+// Copy of a 3xN or 4xN matrix as a Nx3 or Nx4 array
+template <typename T, typename Matrix>
+py::array_t<T> to_rows(const Matrix &M) {
+    py::array_t<T> result({(py::ssize_t) M.cols(), (py::ssize_t) M.rows()});
+    auto r = result.template mutable_unchecked<2>();
+    for (py::ssize_t i = 0; i < r.shape(0); ++i)
+        for (py::ssize_t j = 0; j < r.shape(1); ++j)
+            r(i, j) = (T) M(j, i);
+    return result;
+}
+
+// Copy of an Eigen vector as a 1D array
+template <typename T, typename Vector>
+py::array_t<T> to_array(const Vector &v) {
+    return py::array_t<T>((py::ssize_t) v.size(), (const T *) v.data());
+}
+
+// Sorted vertex set as a 1D array
+py::array_t<uint32_t> to_array(const std::set<uint32_t> &set) {
+    std::vector<uint32_t> list(set.begin(), set.end());
+    return py::array_t<uint32_t>((py::ssize_t) list.size(), list.data());
+}
+
+py::tuple build_dedge_kernel(FloatArray vertices, IndexArray faces, bool parallel) {
+    MatrixXf V = to_vertices(vertices);
+    MatrixXu F = to_faces(faces);
+    VectorXu V2E, E2E;
+    VectorXb boundary, nonManifold;
+    {
+        LogCapture capture;
+        if (parallel)
+            build_dedge_parallel(F, V, V2E, E2E, boundary, nonManifold);
+        else
+            build_dedge(F, V, V2E, E2E, boundary, nonManifold);
+    }
+    return py::make_tuple(to_array<uint32_t>(V2E), to_array<uint32_t>(E2E),
+                          to_array<bool>(boundary), to_array<bool>(nonManifold));
+}
+
+py::tuple subdivide_kernel(FloatArray vertices, IndexArray faces, Float maxLength,
+                           bool parallel) {
+    MatrixXf V = to_vertices(vertices);
+    MatrixXu F = to_faces(faces);
+    if (F.rows() != 3)
+        throw std::runtime_error("Faces must be a Nx3 array");
+    VectorXu V2E, E2E;
+    VectorXb boundary, nonManifold;
+    {
+        LogCapture capture;
+        build_dedge_parallel(F, V, V2E, E2E, boundary, nonManifold);
+        if (parallel)
+            subdivide_parallel(F, V, V2E, E2E, boundary, nonManifold, maxLength);
+        else
+            subdivide(F, V, V2E, E2E, boundary, nonManifold, maxLength, true);
+    }
+    return py::make_tuple(to_rows<Float>(V), to_rows<int>(F), to_array<uint32_t>(E2E),
+                          to_array<bool>(boundary), to_array<bool>(nonManifold));
+}
+
+py::tuple reorder_vertices_kernel(FloatArray vertices, IndexArray faces,
+                                  const std::string &ordering) {
+    MatrixXf V = to_vertices(vertices), N;
+    MatrixXu F = to_faces(faces);
+    {
+        LogCapture capture;
+        reorder_vertices(F, V, N, parse_vertex_ordering(ordering));
+    }
+    return py::make_tuple(to_rows<Float>(V), to_rows<int>(F));
+}
+
+py::tuple load_mesh_kernel(const std::string &path) {
+    MatrixXu F;
+    MatrixXf V, N;
+    {
+        LogCapture capture;
+        load_mesh_or_pointcloud(path, F, V, N);
+    }
+    return py::make_tuple(to_rows<Float>(V), to_rows<int>(F));
+}
+
+py::tuple normals_kernel(FloatArray vertices, IndexArray faces, Float creaseAngle,
+                         bool parallel) {
+    MatrixXf V = to_vertices(vertices), N;
+    MatrixXu F = to_faces(faces);
+    if (F.rows() != 3)
+        throw std::runtime_error("Faces must be a Nx3 array");
+    VectorXu V2E, E2E;
+    VectorXb boundary, nonManifold;
+    std::set<uint32_t> creases;
+    {
+        LogCapture capture;
+        build_dedge_parallel(F, V, V2E, E2E, boundary, nonManifold);
+        if (parallel)
+            generate_normals_parallel(F, V, V2E, E2E, nonManifold, creaseAngle, N, creases);
+        else if (creaseAngle >= 0)
+            generate_crease_normals(F, V, V2E, E2E, boundary, nonManifold,
+                                    creaseAngle, N, creases);
+        else
+            generate_smooth_normals(F, V, V2E, E2E, nonManifold, N);
+    }
+    return py::make_tuple(to_rows<Float>(N), to_array(creases));
+}
+
+py::dict mesh_stats_kernel(FloatArray vertices, IndexArray faces, bool parallel) {
+    MatrixXf V = to_vertices(vertices);
+    MatrixXu F = to_faces(faces);
+    MeshStats stats;
+    VectorXf faceAreas;
+    {
+        LogCapture capture;
+        stats = parallel ? compute_mesh_stats_parallel(F, V, &faceAreas)
+                         : compute_mesh_stats(F, V, true);
+    }
+    py::dict result;
+    result["surface_area"] = (double) stats.mSurfaceArea;
+    result["average_edge_length"] = (double) stats.mAverageEdgeLength;
+    result["maximum_edge_length"] = (double) stats.mMaximumEdgeLength;
+    result["weighted_center"] = to_array<Float>(Vector3f(stats.mWeightedCenter));
+    result["bbox_min"] = to_array<Float>(Vector3f(stats.mAABB.min));
+    result["bbox_max"] = to_array<Float>(Vector3f(stats.mAABB.max));
+    if (parallel)
+        result["face_areas"] = to_array<Float>(faceAreas);
+    return result;
+}
+
+py::array_t<Float> dual_areas_kernel(FloatArray vertices, IndexArray faces, bool parallel,
+                                     bool cachedFaceAreas) {
+    MatrixXf V = to_vertices(vertices);
+    MatrixXu F = to_faces(faces);
+    VectorXu V2E, E2E;
+    VectorXb boundary, nonManifold;
+    VectorXf A, faceAreas;
+    {
+        LogCapture capture;
+        build_dedge_parallel(F, V, V2E, E2E, boundary, nonManifold);
+        if (!parallel) {
+            compute_dual_vertex_areas(F, V, V2E, E2E, nonManifold, A);
+        } else {
+            if (cachedFaceAreas)
+                compute_mesh_stats_parallel(F, V, &faceAreas);
+            compute_dual_vertex_areas_parallel(F, V, V2E, E2E, nonManifold, faceAreas, A);
+        }
+    }
+    return to_array<Float>(A);
+}
+
+/* Level 0 of a hierarchy as prepare_stages() sets it up for a mesh that
+   needs no subdivision, with crease normals if 'creaseAngle' >= 0 */
+void setup_hierarchy(MultiResolutionHierarchy &mRes, MatrixXf V, MatrixXu F,
+                     Float creaseAngle, std::set<uint32_t> &creases) {
+    VectorXu V2E, E2E;
+    VectorXb boundary, nonManifold;
+    MatrixXf N;
+    VectorXf A;
+    build_dedge_parallel(F, V, V2E, E2E, boundary, nonManifold);
+    AdjacencyMatrix adj = generate_adjacency_matrix_uniform(F, V2E, E2E, nonManifold);
+    generate_normals_parallel(F, V, V2E, E2E, nonManifold, creaseAngle, N, creases);
+    compute_dual_vertex_areas_parallel(F, V, V2E, E2E, nonManifold, VectorXf(), A);
+    mRes.setE2E(std::move(E2E));
+    mRes.setAdj(std::move(adj));
+    mRes.setF(std::move(F));
+    mRes.setV(std::move(V));
+    mRes.setA(std::move(A));
+    mRes.setN(std::move(N));
+}
+
+// Adjacency matrix of 'size' vertices as (offsets, ids, weights)
+py::tuple adjacency_arrays(const AdjacencyMatrix adj, uint32_t size) {
+    size_t nLinks = adj[size] - adj[0];
+    py::array_t<uint32_t> offsets((py::ssize_t) size + 1), ids((py::ssize_t) nLinks);
+    py::array_t<Float> weights((py::ssize_t) nLinks);
+    auto o = offsets.mutable_unchecked<1>();
+    auto id = ids.mutable_unchecked<1>();
+    auto w = weights.mutable_unchecked<1>();
+    for (uint32_t i = 0; i <= size; ++i)
+        o(i) = (uint32_t) (adj[i] - adj[0]);
+    for (size_t k = 0; k < nLinks; ++k) {
+        id(k) = adj[0][k].id;
+        w(k) = adj[0][k].weight;
+    }
+    return py::make_tuple(offsets, ids, weights);
+}
+
+// Per-level arrays of a hierarchy, the level 0 faces and the crease vertices
+py::dict hierarchy_arrays(MultiResolutionHierarchy &mRes, const std::set<uint32_t> &creases) {
+    typedef HierarchyAccess H;
+    py::list levels;
+    for (size_t l = 0; l < H::V(mRes).size(); ++l) {
+        uint32_t size = (uint32_t) H::V(mRes)[l].cols();
+        py::dict level;
+        level["V"] = to_rows<Float>(H::V(mRes)[l]);
+        level["N"] = to_rows<Float>(H::N(mRes)[l]);
+        level["A"] = to_array<Float>(H::A(mRes)[l]);
+        level["adjacency"] = adjacency_arrays(H::adj(mRes)[l], size);
+        py::list phases;
+        for (const auto &phase : H::phases(mRes)[l])
+            phases.append(py::array_t<uint32_t>((py::ssize_t) phase.size(), phase.data()));
+        level["phases"] = phases;
+        if (l + 1 < H::V(mRes).size()) {
+            level["to_upper"] = to_rows<uint32_t>(H::toUpper(mRes)[l]);
+            level["to_lower"] = to_array<uint32_t>(H::toLower(mRes)[l]);
+        }
+        levels.append(level);
+    }
+    py::dict result;
+    result["levels"] = levels;
+    result["faces"] = to_rows<uint32_t>(mRes.F());
+    result["creases"] = to_array(creases);
+    return result;
+}
+
+py::dict build_hierarchy_kernel(FloatArray vertices, IndexArray faces, Float creaseAngle,
+                                bool colorContiguous, bool deterministic, bool radix) {
+    MatrixXu F = to_faces(faces);
+    if (F.rows() != 3)
+        throw std::runtime_error("Faces must be a Nx3 array");
+    MultiResolutionHierarchy mRes;
+    std::set<uint32_t> creases;
+    {
+        LogCapture capture;
+        setup_hierarchy(mRes, to_vertices(vertices), std::move(F), creaseAngle, creases);
+        JobArena arena;
+        if (radix)
+            build_hierarchy_radix(mRes, deterministic, &arena);
+        else
+            mRes.build(deterministic);
+        if (colorContiguous)
+            make_phases_contiguous(mRes, creases, &arena);
+    }
+    return hierarchy_arrays(mRes, creases);
+}
+
+/* Boundary constraints of a triangle mesh on every level of its hierarchy,
+   restricted by restrict_constraints() or the upstream propagateConstraints() */
+py::list constraints_kernel(FloatArray vertices, IndexArray faces, int rosy, int posy,
+                            bool parallel) {
+    MatrixXu F = to_faces(faces);
+    if (F.rows() != 3)
+        throw std::runtime_error("Faces must be a Nx3 array");
+    MultiResolutionHierarchy mRes;
+    std::set<uint32_t> creases;
+    {
+        LogCapture capture;
+        MatrixXf V = to_vertices(vertices);
+        MeshStats stats = compute_mesh_stats_parallel(F, V);
+        setup_hierarchy(mRes, std::move(V), std::move(F), -1, creases);
+        mRes.build(true);
+        mRes.setScale(stats.mAverageEdgeLength * 2);
+        mRes.resetSolution();
+        set_boundary_constraints(mRes);
+        if (parallel)
+            restrict_constraints(mRes, rosy, posy);
+        else
+            mRes.propagateConstraints(rosy, posy);
+    }
+    typedef HierarchyAccess H;
+    py::list levels;
+    for (size_t l = 0; l < H::CQ(mRes).size(); ++l) {
+        py::dict level;
+        level["CQ"] = to_rows<Float>(H::CQ(mRes)[l]);
+        level["CO"] = to_rows<Float>(H::CO(mRes)[l]);
+        level["CQw"] = to_array<Float>(H::CQw(mRes)[l]);
+        level["COw"] = to_array<Float>(H::COw(mRes)[l]);
+        levels.append(level);
+    }
+    return levels;
+}
+
+/* Run the fixed schedule of one field on the hierarchy of a triangle mesh,
+   without the GIL, under 'control'. The orientation field is solved first,
+   outside the control, when the position field is requested. Returns false
+   if the solve was cancelled */
+bool solve_field_kernel(FloatArray vertices, IndexArray faces, SolverControl &control,
+                        const std::string &field, int maxIterations) {
+    if (field != "orientation" && field != "position")
+        throw std::invalid_argument("field must be 'orientation' or 'position'");
+    MatrixXu F = to_faces(faces);
+    if (F.rows() != 3)
+        throw std::runtime_error("Faces must be a Nx3 array");
+    MatrixXf V = to_vertices(vertices);
+    LogCapture capture;
+    py::gil_scoped_release release;
+    MultiResolutionHierarchy mRes;
+    std::set<uint32_t> creases;
+    MeshStats stats = compute_mesh_stats_parallel(F, V);
+    setup_hierarchy(mRes, std::move(V), std::move(F), -1, creases);
+    mRes.build(true);
+    mRes.setScale(stats.mAverageEdgeLength * 2);
+    mRes.resetSolution();
+
+    SolverOptions opts;
+    opts.max_iterations = maxIterations;
+    SolverTrace trace;
+    if (field == "orientation") {
+        opts.control = &control;
+        return solve_orientations(mRes, opts, trace);
+    }
+    solve_orientations(mRes, opts, trace);
+    opts.control = &control;
+    return solve_positions(mRes, opts, trace);
+}
+
+} // namespace
+
+void register_testing(py::module &m) {
+    m.def("build_dedge", &build_dedge_kernel,
+          py::arg("vertices"), py::arg("faces"), py::arg("parallel"),
+          "Directed edges of a mesh from build_dedge_parallel() or, with\n"
+          "parallel=False, the upstream build_dedge(). Returns (V2E, E2E,\n"
+          "boundary, nonManifold)");
+
+    m.def("subdivide", &subdivide_kernel,
+          py::arg("vertices"), py::arg("faces"), py::arg("max_length"),
+          py::arg("parallel") = true,
+          "Split the edges of a triangle mesh longer than 'max_length' with\n"
+          "subdivide_parallel() or, with parallel=False, the upstream\n"
+          "deterministic subdivide(). Returns (vertices, faces, E2E, boundary,\n"
+          "nonManifold)");
+
+    m.def("reorder_vertices", &reorder_vertices_kernel,
+          py::arg("vertices"), py::arg("faces"), py::arg("ordering"),
+          "Renumber a mesh with reorder_vertices(). Returns (vertices, faces)");
+
+    m.def("load_mesh", &load_mesh_kernel, py::arg("path"),
+          "Read a mesh with the upstream load_mesh_or_pointcloud(). Returns\n"
+          "(vertices, faces)");
+
+    m.def("mesh_stats", &mesh_stats_kernel,
+          py::arg("vertices"), py::arg("faces"), py::arg("parallel"),
+          "Statistics of a mesh from compute_mesh_stats_parallel() or, with\n"
+          "parallel=False, the upstream compute_mesh_stats(). Returns a dict;\n"
+          "the parallel pass adds 'face_areas'");
+
+    m.def("dual_areas", &dual_areas_kernel,
+          py::arg("vertices"), py::arg("faces"), py::arg("parallel"),
+          py::arg("cached_face_areas") = true,
+          "Dual vertex areas from compute_dual_vertex_areas_parallel(), with\n"
+          "the face areas of the statistics pass or computed on the fly, or,\n"
+          "with parallel=False, the upstream compute_dual_vertex_areas()");
+
+    m.def("normals", &normals_kernel,
+          py::arg("vertices"), py::arg("faces"), py::arg("crease_angle") = -1.0f,
+          py::arg("parallel") = true,
+          "Vertex normals of a triangle mesh from generate_normals_parallel()\n"
+          "or, with parallel=False, the upstream generate_smooth_normals() or\n"
+          "generate_crease_normals(). Returns (normals, creases)");
+
+    m.def("build_hierarchy", &build_hierarchy_kernel,
+          py::arg("vertices"), py::arg("faces"), py::arg("crease_angle") = -1.0f,
+          py::arg("color_contiguous") = false, py::arg("deterministic") = true,
+          py::arg("radix") = false,
+          "Build the hierarchy of a triangle mesh as remesh() does, with\n"
+          "build_hierarchy_radix() if 'radix' is set, optionally followed by\n"
+          "make_phases_contiguous(). Returns a dict with 'levels'\n"
+          "(a list of dicts of V, N, A, adjacency = (offsets, ids, weights),\n"
+          "phases, to_upper and to_lower), 'faces' and 'creases'");
+
+    m.def("solve_field", &solve_field_kernel,
+          py::arg("vertices"), py::arg("faces"), py::arg("control"),
+          py::arg("field") = "orientation", py::arg("max_iterations") = 6,
+          "Run the fixed solver schedule of 'orientation' or 'position' on\n"
+          "the hierarchy of a triangle mesh under a SolverControl, without the\n"
+          "GIL. Returns False if it was cancelled");
+
+    m.def("constraints", &constraints_kernel,
+          py::arg("vertices"), py::arg("faces"), py::arg("rosy") = 4,
+          py::arg("posy") = 4, py::arg("parallel") = true,
+          "Boundary constraints of a triangle mesh as remesh() sets them with\n"
+          "align_to_boundaries, restricted to the coarser levels by\n"
+          "restrict_constraints() or, with parallel=False, the upstream\n"
+          "propagateConstraints(). Returns a list of dicts of CQ, CO, CQw\n"
+          "and COw per level");
+}
@@ -0,0 +1,17 @@
+/*
+    testing.h -- Kernel entry points for the test suite
+
+    Several stages of the pipeline replace an upstream routine by a parallel
+    or vectorized one that is meant to produce the same result. The test
+    suite checks this by calling both on the same arrays through the
+    _testing submodule of each backend. The arrays are converted directly,
+    without the OBJ round trip of remesh(), so vertex and face indices are
+    preserved.
+*/
+
+#pragma once
+
+#include <pybind11/pybind11.h>
+
+// Define the functions of the _testing submodule in 'm'
+extern void register_testing(pybind11::module &m);
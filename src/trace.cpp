@@ -0,0 +1,117 @@
+/*
+    trace.cpp -- Timeline tracing of the pipeline stages
+
+    A thread registers its ring buffer on its first event; this is the only
+    step that takes a lock. The write position of a buffer is only advanced
+    by its owner and published with a release store, so trace_stop() reads
+    consistent events once recording has stopped. trace_start() bumps a
+    generation counter instead of touching the buffers of other threads;
+    each owner clears its buffer when it sees the new generation.
+*/
+
+#include "trace.h"
+
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+
+#if defined(PYIM_TRACING)
+
+std::atomic<bool> trace_recording(false);
+
+namespace {
+
+struct ThreadBuffer {
+    uint32_t thread = 0;
+    uint64_t generation = 0;
+    std::vector<TraceEvent> events;    // size is a power of two
+    std::atomic<uint64_t> count{0};    // events written in this generation
+};
+
+std::mutex registryMutex;
+std::vector<std::unique_ptr<ThreadBuffer>> registry;
+std::atomic<uint64_t> generation(0);
+std::atomic<size_t> capacity(0);
+std::atomic<uint64_t> origin(0);
+thread_local ThreadBuffer *localBuffer = nullptr;
+
+ThreadBuffer *register_thread() {
+    std::unique_ptr<ThreadBuffer> buffer(new ThreadBuffer());
+    std::lock_guard<std::mutex> guard(registryMutex);
+    buffer->thread = (uint32_t) registry.size();
+    buffer->generation = (uint64_t) -1;
+    registry.push_back(std::move(buffer));
+    return registry.back().get();
+}
+
+} // namespace
+
+void trace_record(const char *name, uint64_t begin, uint64_t end, int32_t arg) {
+    ThreadBuffer *buffer = localBuffer;
+    if (!buffer)
+        buffer = localBuffer = register_thread();
+    uint64_t current = generation.load(std::memory_order_acquire);
+    if (buffer->generation != current) {
+        buffer->events.assign(capacity.load(std::memory_order_relaxed), TraceEvent());
+        buffer->count.store(0, std::memory_order_relaxed);
+        buffer->generation = current;
+    }
+    uint64_t index = buffer->count.load(std::memory_order_relaxed);
+    TraceEvent &event = buffer->events[index & (buffer->events.size() - 1)];
+    event.name = name;
+    event.begin = begin;
+    event.end = end;
+    event.arg = arg;
+    buffer->count.store(index + 1, std::memory_order_release);
+}
+
+bool trace_available() { return true; }
+
+void trace_start(size_t requested) {
+    size_t size = 1;
+    while (size < requested)
+        size *= 2;
+    trace_recording.store(false);
+    capacity.store(size);
+    origin.store(trace_clock());
+    generation.fetch_add(1, std::memory_order_release);
+    trace_recording.store(true);
+}
+
+std::vector<TraceThreadEvents> trace_stop() {
+    trace_recording.store(false);
+    uint64_t current = generation.load(std::memory_order_acquire);
+
+    std::vector<TraceThreadEvents> result;
+    std::lock_guard<std::mutex> guard(registryMutex);
+    for (const auto &buffer : registry) {
+        uint64_t count = buffer->count.load(std::memory_order_acquire);
+        if (buffer->generation != current || count == 0)
+            continue;
+        const uint64_t size = buffer->events.size();
+        uint64_t first = count > size ? count - size : 0;
+        TraceThreadEvents thread;
+        thread.thread = buffer->thread;
+        thread.events.reserve((size_t) (count - first));
+        for (uint64_t i = first; i < count; ++i)
+            thread.events.push_back(buffer->events[i & (size - 1)]);
+        result.push_back(std::move(thread));
+    }
+    return result;
+}
+
+uint64_t trace_origin() { return origin.load(); }
+
+#else
+
+bool trace_available() { return false; }
+
+void trace_start(size_t) {
+    throw std::runtime_error("pyinstantmeshes was built without tracing support (PYIM_TRACING)");
+}
+
+std::vector<TraceThreadEvents> trace_stop() { return std::vector<TraceThreadEvents>(); }
+
+uint64_t trace_origin() { return 0; }
+
+#endif
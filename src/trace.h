@@ -0,0 +1,86 @@
+/*
+    trace.h -- Timeline tracing of the pipeline stages
+
+    PYIM_TRACE_SCOPE("name") records the time between its construction and
+    the end of the enclosing scope as a complete event of the calling
+    thread. Every thread appends to its own ring buffer, so recording takes
+    two clock reads and a few stores, without locks or atomic read-modify-
+    write operations. When tracing is not started, a scope only loads one
+    relaxed flag. Builds without PYIM_TRACING compile the scopes out.
+*/
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+struct TraceEvent {
+    const char *name;     // string literal of the scope
+    uint64_t begin, end;  // nanoseconds, see trace_clock()
+    int32_t arg;          // e.g. the hierarchy level, -1 if unused
+};
+
+// Events of one thread, oldest first
+struct TraceThreadEvents {
+    uint32_t thread;      // registration order of the thread
+    std::vector<TraceEvent> events;
+};
+
+// Was this build compiled with PYIM_TRACING?
+extern bool trace_available();
+
+/* Clear all buffers and start recording, keeping at most 'capacity' (rounded
+   up to a power of two) of the latest events per thread */
+extern void trace_start(size_t capacity);
+
+/* Stop recording and return the events of all threads. Call this when no
+   job is running; events of scopes that are still open are not included */
+extern std::vector<TraceThreadEvents> trace_stop();
+
+// Time of the trace_start() call, on the scale of trace_clock()
+extern uint64_t trace_origin();
+
+inline uint64_t trace_clock() {
+    return (uint64_t) std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+#if defined(PYIM_TRACING)
+
+extern std::atomic<bool> trace_recording;
+
+// Append an event to the ring buffer of the calling thread
+extern void trace_record(const char *name, uint64_t begin, uint64_t end, int32_t arg);
+
+class TraceScope {
+public:
+    explicit TraceScope(const char *name, int32_t arg = -1)
+        : mName(trace_recording.load(std::memory_order_relaxed) ? name : nullptr),
+          mArg(arg), mBegin(mName ? trace_clock() : 0) { }
+
+    ~TraceScope() {
+        if (mName)
+            trace_record(mName, mBegin, trace_clock(), mArg);
+    }
+
+private:
+    TraceScope(const TraceScope &) = delete;
+    TraceScope &operator=(const TraceScope &) = delete;
+
+    const char *mName;
+    int32_t mArg;
+    uint64_t mBegin;
+};
+
+#define PYIM_TRACE_CONCAT_(a, b) a##b
+#define PYIM_TRACE_CONCAT(a, b) PYIM_TRACE_CONCAT_(a, b)
+#define PYIM_TRACE_SCOPE(...) \
+    TraceScope PYIM_TRACE_CONCAT(pyim_trace_scope_, __LINE__)(__VA_ARGS__)
+
+#else
+
+#define PYIM_TRACE_SCOPE(...) do { } while (0)
+
+#endif
@@ -0,0 +1,249 @@
+/*
+    vertex_order.cpp -- Cache-friendly vertex and face ordering
+
+    The space-filling curve orders quantize vertex positions to 21 bits per
+    axis within the bounding box and sort by the interleaved Morton or
+    Hilbert index. The RCM order is a reverse Cuthill-McKee traversal of the
+    face connectivity, which minimizes the bandwidth of the vertex graph.
+*/
+
+#include "vertex_order.h"
+#include "trace.h"
+
+#include <tbb/parallel_sort.h>
+#include <algorithm>
+#include <stdexcept>
+
+namespace {
+
+const int CURVE_BITS = 21;
+
+// Spread the lower 21 bits of x so that there are two zero bits between each
+inline uint64_t spread_bits_3(uint64_t x) {
+    x &= 0x1fffff;
+    x = (x | x << 32) & 0x1f00000000ffffull;
+    x = (x | x << 16) & 0x1f0000ff0000ffull;
+    x = (x | x << 8)  & 0x100f00f00f00f00full;
+    x = (x | x << 4)  & 0x10c30c30c30c30c3ull;
+    x = (x | x << 2)  & 0x1249249249249249ull;
+    return x;
+}
+
+inline uint64_t morton_index(uint32_t x, uint32_t y, uint32_t z) {
+    return (spread_bits_3(x) << 2) | (spread_bits_3(y) << 1) | spread_bits_3(z);
+}
+
+/* Hilbert index via Skilling's transform ("Programming the Hilbert curve",
+   AIP Conf. Proc. 707, 2004): convert the coordinates to the transposed
+   Hilbert index in place, then interleave their bits */
+inline uint64_t hilbert_index(uint32_t x, uint32_t y, uint32_t z) {
+    uint32_t X[3] = { x, y, z };
+    const uint32_t M = 1u << (CURVE_BITS - 1);
+
+    for (uint32_t Q = M; Q > 1; Q >>= 1) {
+        uint32_t P = Q - 1;
+        for (int i = 0; i < 3; ++i) {
+            if (X[i] & Q) {
+                X[0] ^= P;
+            } else {
+                uint32_t t = (X[0] ^ X[i]) & P;
+                X[0] ^= t;
+                X[i] ^= t;
+            }
+        }
+    }
+
+    for (int i = 1; i < 3; ++i)
+        X[i] ^= X[i - 1];
+    uint32_t t = 0;
+    for (uint32_t Q = M; Q > 1; Q >>= 1)
+        if (X[2] & Q)
+            t ^= Q - 1;
+    for (int i = 0; i < 3; ++i)
+        X[i] ^= t;
+
+    return morton_index(X[0], X[1], X[2]);
+}
+
+// Order vertices along a space-filling curve through their positions
+void curve_order(const MatrixXf &V, bool hilbert, std::vector<uint32_t> &order) {
+    const uint32_t nVertices = (uint32_t) V.cols();
+
+    Vector3f min = V.rowwise().minCoeff(), max = V.rowwise().maxCoeff();
+    Float extent = (max - min).maxCoeff();
+    Float quantization = extent > 0 ? ((1u << CURVE_BITS) - 1) / extent : 0;
+
+    std::vector<std::pair<uint64_t, uint32_t>> keys(nVertices);
+    tbb::parallel_for(
+        tbb::blocked_range<uint32_t>(0u, nVertices, GRAIN_SIZE),
+        [&](const tbb::blocked_range<uint32_t> &range) {
+            for (uint32_t i = range.begin(); i != range.end(); ++i) {
+                Vector3f p = (V.col(i) - min) * quantization;
+                uint32_t x = (uint32_t) p.x(), y = (uint32_t) p.y(), z = (uint32_t) p.z();
+                keys[i] = std::make_pair(hilbert ? hilbert_index(x, y, z)
+                                                 : morton_index(x, y, z), i);
+            }
+        }
+    );
+
+    tbb::parallel_sort(keys.begin(), keys.end());
+
+    order.resize(nVertices);
+    for (uint32_t i = 0; i < nVertices; ++i)
+        order[i] = keys[i].second;
+}
+
+// Reverse Cuthill-McKee order of the vertex graph spanned by the face edges
+void rcm_order(const MatrixXu &F, uint32_t nVertices, std::vector<uint32_t> &order) {
+    /* Compressed neighbor lists (duplicates removed) */
+    std::vector<uint32_t> offset(nVertices + 1, 0);
+    for (uint32_t f = 0; f < F.cols(); ++f)
+        for (uint32_t i = 0; i < F.rows(); ++i)
+            offset[F(i, f) + 1] += 2;
+    for (uint32_t i = 0; i < nVertices; ++i)
+        offset[i + 1] += offset[i];
+
+    std::vector<uint32_t> fill(offset.begin(), offset.end() - 1);
+    std::vector<uint32_t> neighbors(offset[nVertices]);
+    for (uint32_t f = 0; f < F.cols(); ++f) {
+        for (uint32_t i = 0; i < F.rows(); ++i) {
+            uint32_t v = F(i, f);
+            neighbors[fill[v]++] = F((i + 1) % F.rows(), f);
+            neighbors[fill[v]++] = F((i + F.rows() - 1) % F.rows(), f);
+        }
+    }
+
+    std::vector<uint32_t> degree(nVertices);
+    tbb::parallel_for(
+        tbb::blocked_range<uint32_t>(0u, nVertices, GRAIN_SIZE),
+        [&](const tbb::blocked_range<uint32_t> &range) {
+            for (uint32_t i = range.begin(); i != range.end(); ++i) {
+                auto begin = neighbors.begin() + offset[i],
+                     end = neighbors.begin() + offset[i + 1];
+                std::sort(begin, end);
+                end = std::unique(begin, end);
+                std::fill(end, neighbors.begin() + offset[i + 1], INVALID);
+                degree[i] = (uint32_t) (end - begin);
+            }
+        }
+    );
+
+    /* Start every connected component at a vertex of minimal degree */
+    std::vector<uint32_t> seeds(nVertices);
+    for (uint32_t i = 0; i < nVertices; ++i)
+        seeds[i] = i;
+    std::stable_sort(seeds.begin(), seeds.end(),
+        [&](uint32_t a, uint32_t b) { return degree[a] < degree[b]; });
+
+    std::vector<bool> visited(nVertices, false);
+    order.clear();
+    order.reserve(nVertices);
+    for (uint32_t seed : seeds) {
+        if (visited[seed])
+            continue;
+        visited[seed] = true;
+        order.push_back(seed);
+
+        for (size_t head = order.size() - 1; head < order.size(); ++head) {
+            uint32_t v = order[head];
+            size_t first = order.size();
+            for (uint32_t j = offset[v]; j < offset[v] + degree[v]; ++j) {
+                uint32_t n = neighbors[j];
+                if (visited[n])
+                    continue;
+                visited[n] = true;
+                order.push_back(n);
+            }
+            std::stable_sort(order.begin() + first, order.end(),
+                [&](uint32_t a, uint32_t b) { return degree[a] < degree[b]; });
+        }
+    }
+
+    std::reverse(order.begin(), order.end());
+}
+
+} // namespace
+
+VertexOrdering parse_vertex_ordering(const std::string &name) {
+    if (name == "none")
+        return VertexOrdering::None;
+    else if (name == "morton")
+        return VertexOrdering::Morton;
+    else if (name == "hilbert")
+        return VertexOrdering::Hilbert;
+    else if (name == "rcm")
+        return VertexOrdering::RCM;
+    throw std::invalid_argument("Unknown vertex ordering \"" + name +
+                                "\" (expected 'none', 'morton', 'hilbert' or 'rcm')");
+}
+
+void reorder_vertices(MatrixXu &F, MatrixXf &V, MatrixXf &N,
+                      VertexOrdering ordering) {
+    PYIM_TRACE_SCOPE("reorder_vertices");
+    if (ordering == VertexOrdering::None || V.cols() == 0)
+        return;
+
+    cout << "Reordering vertices .. ";
+    cout.flush();
+    Timer<> timer;
+
+    const uint32_t nVertices = (uint32_t) V.cols();
+    std::vector<uint32_t> order;
+    if (ordering == VertexOrdering::RCM && F.size() > 0)
+        rcm_order(F, nVertices, order);
+    else
+        curve_order(V, ordering != VertexOrdering::Morton, order);
+
+    std::vector<uint32_t> rank(nVertices);
+    MatrixXf V_new(V.rows(), nVertices);
+    bool hasNormals = N.cols() == V.cols();
+    MatrixXf N_new(N.rows(), hasNormals ? nVertices : 0);
+    tbb::parallel_for(
+        tbb::blocked_range<uint32_t>(0u, nVertices, GRAIN_SIZE),
+        [&](const tbb::blocked_range<uint32_t> &range) {
+            for (uint32_t i = range.begin(); i != range.end(); ++i) {
+                uint32_t j = order[i];
+                rank[j] = i;
+                V_new.col(i) = V.col(j);
+                if (hasNormals)
+                    N_new.col(i) = N.col(j);
+            }
+        }
+    );
+    V = std::move(V_new);
+    if (hasNormals)
+        N = std::move(N_new);
+
+    if (F.size() > 0) {
+        /* Renumber the faces and sort them by their first vertex in the new order */
+        const uint32_t nFaces = (uint32_t) F.cols();
+        std::vector<std::pair<uint32_t, uint32_t>> faceKeys(nFaces);
+        tbb::parallel_for(
+            tbb::blocked_range<uint32_t>(0u, nFaces, GRAIN_SIZE),
+            [&](const tbb::blocked_range<uint32_t> &range) {
+                for (uint32_t f = range.begin(); f != range.end(); ++f) {
+                    uint32_t key = INVALID;
+                    for (uint32_t i = 0; i < F.rows(); ++i) {
+                        F(i, f) = rank[F(i, f)];
+                        key = std::min(key, F(i, f));
+                    }
+                    faceKeys[f] = std::make_pair(key, f);
+                }
+            }
+        );
+
+        tbb::parallel_sort(faceKeys.begin(), faceKeys.end());
+
+        MatrixXu F_new(F.rows(), nFaces);
+        tbb::parallel_for(
+            tbb::blocked_range<uint32_t>(0u, nFaces, GRAIN_SIZE),
+            [&](const tbb::blocked_range<uint32_t> &range) {
+                for (uint32_t f = range.begin(); f != range.end(); ++f)
+                    F_new.col(f) = F.col(faceKeys[f].second);
+            }
+        );
+        F = std::move(F_new);
+    }
+
+    cout << "done. (took " << timeString(timer.value()) << ")" << endl;
+}
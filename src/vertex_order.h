@@ -0,0 +1,30 @@
+/*
+    vertex_order.h -- Cache-friendly vertex and face ordering
+
+    Renumbers the input before any connectivity is built, so that vertices
+    that are close on the surface are also close in memory. The hierarchy
+    and the field solver inherit this order from the finest level.
+*/
+
+#pragma once
+
+#include "common.h"
+#include <string>
+
+enum class VertexOrdering {
+    None,
+    Morton,
+    Hilbert,
+    RCM
+};
+
+// Parse 'none', 'morton', 'hilbert' or 'rcm' (throws std::invalid_argument)
+extern VertexOrdering parse_vertex_ordering(const std::string &name);
+
+/**
+ * Permute the columns of V (and N, if it stores per-vertex normals) and
+ * remap F accordingly. Faces are then sorted by their smallest vertex index.
+ * Point clouds (empty F) ordered with RCM fall back to the Hilbert order.
+ */
+extern void reorder_vertices(MatrixXu &F, MatrixXf &V, MatrixXf &N,
+                             VertexOrdering ordering);
@@ -0,0 +1,570 @@
+"""
+Tests that compare the kernels of this package with the upstream routines
+they replace, through the _testing submodule of the backend.
+"""
+
+import threading
+import time
+
+import pytest
+import numpy as np
+import pyinstantmeshes
+from pyinstantmeshes._backend import get_backend
+
+
+@pytest.fixture
+def kernels():
+    """The _testing submodule of the single precision backend."""
+    return get_backend("float32")._testing
+
+
+@pytest.fixture
+def serial():
+    """Run TBB work on one thread inside the test."""
+    def run(function, *args, **kwargs):
+        pyinstantmeshes.set_num_threads(1)
+        try:
+            return function(*args, **kwargs)
+        finally:
+            pyinstantmeshes.set_num_threads(None)
+    return run
+
+
+def grid(n, quads=False):
+    """Consistently oriented n x n grid in the plane z = 0."""
+    x, y = np.meshgrid(np.arange(n + 1), np.arange(n + 1), indexing="ij")
+    vertices = np.stack([x.ravel(), y.ravel(), np.zeros(x.size)], axis=-1)
+    i, j = np.meshgrid(np.arange(n), np.arange(n), indexing="ij")
+    a = (i * (n + 1) + j).ravel()
+    b = a + n + 1
+    if quads:
+        faces = np.stack([a, b, b + 1, a + 1], axis=-1)
+    else:
+        faces = np.concatenate([np.stack([a, b, b + 1], axis=-1),
+                                np.stack([a, b + 1, a + 1], axis=-1)])
+    return vertices.astype(np.float32), faces.astype(np.int32)
+
+
+def dirty_grid(n, quads=False):
+    """
+    Grid with boundary edges, two fins (a third face on an interior edge),
+    a bowtie vertex at the corner and an unreferenced vertex.
+    """
+    vertices, faces = grid(n, quads)
+    deg = faces.shape[1]
+    base = len(vertices)
+    a, b = n // 2 * (n + 1) + n // 2, (n // 2 + 1) * (n + 1) + n // 2
+    c, d = 2 * (n + 1) + 1, 2 * (n + 1) + 2
+    extra = np.array([[0.5 + n // 2, n // 2, 1.0], [2.0, 1.5, -1.0],
+                      [-1.0, -0.5, 0.0], [-0.5, -1.0, 0.0], [-0.25, -0.75, 0.0],
+                      [n + 5.0, n + 5.0, 0.0]], dtype=np.float32)
+    fins = [[a, b, base], [d, c, base + 1]]
+    bowtie = [[0, base + 2, base + 3]]
+    if deg == 4:
+        fins = [face + [face[-1]] for face in fins]
+        bowtie = [[0, base + 2, base + 4, base + 3]]
+    faces = np.concatenate([faces, np.array(fins + bowtie, dtype=np.int32)])
+    return np.concatenate([vertices, extra]), faces
+
+
+class TestDirectedEdges:
+    """build_dedge_parallel() against the upstream build_dedge()."""
+
+    @pytest.mark.parametrize("quads", [False, True])
+    def test_build_dedge_matches_upstream(self, kernels, serial, quads):
+        """Test that all four arrays match the serial upstream pass exactly."""
+        vertices, faces = dirty_grid(40, quads)
+
+        # The upstream pass picks V2E by a race between threads; on one
+        # thread it takes the first outgoing edge, as the parallel pass does
+        expected = serial(kernels.build_dedge, vertices, faces, parallel=False)
+        result = kernels.build_dedge(vertices, faces, parallel=True)
+
+        for name, a, b in zip(["V2E", "E2E", "boundary", "nonManifold"],
+                              result, expected):
+            assert np.array_equal(a, b), name
+
+        V2E, E2E, boundary, non_manifold = result
+        assert non_manifold.sum() == 4
+        assert boundary[0] and boundary.sum() > 4 * 40
+        assert V2E[-1] == np.iinfo(np.uint32).max
+
+    def test_build_dedge_thread_count(self, kernels, serial):
+        """Test that the parallel pass does not depend on the thread count."""
+        vertices, faces = dirty_grid(40)
+
+        single = serial(kernels.build_dedge, vertices, faces, parallel=True)
+        result = kernels.build_dedge(vertices, faces, parallel=True)
+
+        for a, b in zip(result, single):
+            assert np.array_equal(a, b)
+
+
+def sorted_rows(array):
+    """Rows of a 2D array in lexicographic order."""
+    return array[np.lexsort(array.T[::-1])]
+
+
+def shuffled(vertices, faces, seed=0):
+    """Renumber the vertices of a mesh randomly."""
+    order = np.random.default_rng(seed).permutation(len(vertices))
+    rank = np.empty_like(order)
+    rank[order] = np.arange(len(order))
+    return vertices[order], rank[faces].astype(np.int32)
+
+
+def bandwidth(faces):
+    """Largest index difference between two corners of a face."""
+    return int((faces.max(axis=1) - faces.min(axis=1)).max())
+
+
+class TestVertexOrdering:
+    """reorder_vertices() with the space-filling curves and RCM."""
+
+    @pytest.mark.parametrize("ordering", ["morton", "hilbert", "rcm"])
+    def test_reorder_is_renumbering(self, kernels, ordering):
+        """Test that the ordering only renumbers vertices and faces."""
+        vertices, faces = shuffled(*grid(24))
+
+        new_vertices, new_faces = kernels.reorder_vertices(vertices, faces, ordering)
+
+        assert np.array_equal(sorted_rows(new_vertices), sorted_rows(vertices))
+        corners = vertices[faces].reshape(len(faces), -1)
+        new_corners = new_vertices[new_faces].reshape(len(new_faces), -1)
+        assert np.array_equal(sorted_rows(new_corners), sorted_rows(corners))
+        assert np.all(np.diff(new_faces.min(axis=1)) >= 0)
+
+    @pytest.mark.parametrize("ordering", ["morton", "hilbert"])
+    def test_curve_order_locality(self, kernels, ordering):
+        """Test that consecutive vertices of a curve order are close."""
+        vertices, faces = shuffled(*grid(32))
+
+        new_vertices, _ = kernels.reorder_vertices(vertices, faces, ordering)
+
+        def step(v):
+            return np.linalg.norm(np.diff(v, axis=0), axis=1).mean()
+        assert step(new_vertices) < step(vertices) / 4
+
+    def test_rcm_bandwidth(self, kernels):
+        """Test that RCM brings the bandwidth of a grid close to its width."""
+        n = 24
+        vertices, faces = shuffled(*grid(n))
+
+        _, new_faces = kernels.reorder_vertices(vertices, faces, "rcm")
+
+        assert bandwidth(new_faces) <= 3 * (n + 1)
+        assert bandwidth(new_faces) < bandwidth(faces)
+
+    def test_rcm_disconnected(self, kernels):
+        """Test RCM on two components: each one gets a contiguous range."""
+        v0, f0 = grid(12)
+        v1, f1 = grid(8)
+        v1 = v1 + np.array([100.0, 0.0, 0.0], dtype=np.float32)
+        vertices = np.concatenate([v0, v1])
+        faces = np.concatenate([f0, f1 + len(v0)]).astype(np.int32)
+        vertices, faces = shuffled(vertices, faces, seed=1)
+
+        new_vertices, new_faces = kernels.reorder_vertices(vertices, faces, "rcm")
+
+        component = new_vertices[:, 0] >= 50.0
+        assert np.count_nonzero(np.diff(component.astype(int))) == 1
+        assert np.array_equal(sorted_rows(new_vertices), sorted_rows(vertices))
+        for mask in (component, ~component):
+            used = np.flatnonzero(mask)
+            inside = np.isin(new_faces, used).all(axis=1)
+            assert bandwidth(new_faces[inside]) <= 3 * 13
+
+    def test_rcm_point_cloud(self, kernels):
+        """Test that RCM falls back to the Hilbert order without faces."""
+        vertices, _ = shuffled(*grid(16))
+        no_faces = np.zeros((0, 3), dtype=np.int32)
+
+        rcm, _ = kernels.reorder_vertices(vertices, no_faces, "rcm")
+        hilbert, _ = kernels.reorder_vertices(vertices, no_faces, "hilbert")
+
+        assert np.array_equal(rcm, hilbert)
+
+    def test_unknown_ordering(self, kernels):
+        """Test that an unknown ordering raises ValueError."""
+        vertices, faces = grid(4)
+
+        with pytest.raises(ValueError, match="Unknown vertex ordering"):
+            kernels.reorder_vertices(vertices, faces, "zorder")
+
+
+def graded_grid(n):
+    """Coarse grid whose columns widen across it, on a wavy surface."""
+    vertices, faces = grid(n)
+    x, y = vertices[:, 0], vertices[:, 1]
+    vertices[:, 0] = x * x / n
+    vertices[:, 2] = 0.3 * np.sin(y)
+    return vertices, faces
+
+
+def edge_lengths(vertices, faces):
+    """Length of every undirected edge of a triangle mesh."""
+    edges = np.concatenate([faces[:, [0, 1]], faces[:, [1, 2]], faces[:, [2, 0]]])
+    edges = np.unique(np.sort(edges, axis=1), axis=0)
+    return np.linalg.norm(vertices[edges[:, 0]] - vertices[edges[:, 1]], axis=1)
+
+
+def boundary_length(vertices, faces, e2e):
+    """Total length of the boundary edges (E2E = INVALID) of a triangle mesh."""
+    open_edges = np.flatnonzero(e2e == 0xFFFFFFFF)
+    start = faces[open_edges // 3, open_edges % 3]
+    end = faces[open_edges // 3, (open_edges + 1) % 3]
+    return np.linalg.norm(vertices[end] - vertices[start], axis=1).sum()
+
+
+def face_area(vertices, faces):
+    """Total area of a triangle mesh."""
+    p = vertices[faces]
+    return 0.5 * np.linalg.norm(np.cross(p[:, 1] - p[:, 0], p[:, 2] - p[:, 0]), axis=1).sum()
+
+
+class TestSubdivide:
+    """subdivide_parallel() against the upstream subdivide()."""
+
+    MAX_LENGTH = 0.25
+
+    def check_mesh(self, kernels, vertices, faces, e2e, n, border_length):
+        """Edges below the threshold, consistent E2E, the grid border kept."""
+        lengths = edge_lengths(vertices, faces)
+        assert np.all(lengths > 0)
+        assert lengths.max() <= self.MAX_LENGTH * (1 + 1e-5)
+
+        _, expected_e2e, boundary, non_manifold = kernels.build_dedge(
+            vertices, faces, parallel=True)
+        assert not np.any(non_manifold)
+        assert np.array_equal(e2e, expected_e2e)
+        inner = np.flatnonzero(e2e != 0xFFFFFFFF)
+        assert np.array_equal(e2e[e2e[inner]], inner)
+        ends = faces[inner // 3, inner % 3]
+        assert np.array_equal(faces[e2e[inner] // 3, (e2e[inner] + 1) % 3], ends)
+
+        # Boundary vertices stay on the border of the parameter domain
+        border = vertices[boundary]
+        assert np.all(np.isclose(border[:, 0], 0) | np.isclose(border[:, 0], n) |
+                      np.isclose(border[:, 1], 0) | np.isclose(border[:, 1], n))
+        assert boundary_length(vertices, faces, e2e) == pytest.approx(border_length, rel=1e-5)
+
+    def test_subdivide_matches_upstream(self, kernels):
+        """Test the result against the upstream subdivide() on a graded grid."""
+        n = 6
+        vertices, faces = graded_grid(n)
+
+        result = kernels.subdivide(vertices, faces, self.MAX_LENGTH)
+        upstream = kernels.subdivide(vertices, faces, self.MAX_LENGTH, parallel=False)
+
+        _, input_e2e, _, _ = kernels.build_dedge(vertices, faces, parallel=True)
+        border_length = boundary_length(vertices, faces, input_e2e)
+        self.check_mesh(kernels, *result[:3], n, border_length)
+        self.check_mesh(kernels, *upstream[:3], n, border_length)
+
+        # Same surface, comparable resolution and edge length distribution
+        assert np.isclose(face_area(*result[:2]), face_area(*upstream[:2]), rtol=1e-4)
+        assert 0.75 < len(result[0]) / len(upstream[0]) < 1.33
+        bins = np.linspace(0, self.MAX_LENGTH, 9)
+        hist, _ = np.histogram(edge_lengths(*result[:2]), bins)
+        expected, _ = np.histogram(edge_lengths(*upstream[:2]), bins)
+        assert 0.5 * np.abs(hist / hist.sum() - expected / expected.sum()).sum() < 0.35
+
+    def test_subdivide_thread_count(self, kernels, serial):
+        """Test that the subdivision does not depend on the thread count."""
+        vertices, faces = graded_grid(6)
+
+        single = serial(kernels.subdivide, vertices, faces, self.MAX_LENGTH)
+        result = kernels.subdivide(vertices, faces, self.MAX_LENGTH)
+
+        for array, expected in zip(result, single):
+            assert np.array_equal(array, expected)
+
+
+def folded_grid(n):
+    """Grid folded along a line, so it has a 90 degree crease and curvature."""
+    vertices, faces = grid(n)
+    x, y = vertices[:, 0], vertices[:, 1]
+    vertices[:, 2] = np.abs(x - n / 2) + 0.3 * np.sin(y)
+    return vertices, faces
+
+
+def contiguous_order(phases, size):
+    """New vertex order of make_phases_contiguous() and its inverse."""
+    placed = np.concatenate([np.sort(phase) for phase in phases]).astype(np.int64)
+    order = np.concatenate([placed, np.setdiff1d(np.arange(size), placed)])
+    rank = np.empty_like(order)
+    rank[order] = np.arange(size)
+    return order, rank
+
+
+def remap(indices, rank):
+    """Replace vertex indices by their rank, keeping INVALID entries."""
+    invalid = indices == np.iinfo(np.uint32).max
+    return np.where(invalid, indices, rank[np.where(invalid, 0, indices)])
+
+
+class TestColorContiguousLayout:
+    """make_phases_contiguous() against the hierarchy it renumbers."""
+
+    @pytest.mark.parametrize("crease_angle", [-1.0, 20.0])
+    def test_layout_is_renumbering(self, kernels, crease_angle):
+        """Test that every level equals the plain one mapped through rank."""
+        vertices, faces = folded_grid(30)
+
+        plain = kernels.build_hierarchy(vertices, faces, crease_angle)
+        result = kernels.build_hierarchy(vertices, faces, crease_angle,
+                                         color_contiguous=True)
+
+        levels = plain["levels"]
+        assert len(result["levels"]) == len(levels) > 2
+        maps = [contiguous_order(level["phases"], len(level["A"]))
+                for level in levels]
+
+        for l, (a, b) in enumerate(zip(result["levels"], levels)):
+            order, rank = maps[l]
+            for name in ("V", "N", "A"):
+                assert np.array_equal(a[name], b[name][order]), (l, name)
+
+            start = 0
+            for phase, old in zip(a["phases"], b["phases"]):
+                assert np.array_equal(phase, np.arange(start, start + len(old)))
+                start += len(old)
+
+            offsets, ids, weights = a["adjacency"]
+            old_offsets, old_ids, old_weights = b["adjacency"]
+            assert np.array_equal(np.diff(offsets), np.diff(old_offsets)[order])
+            for i in range(len(order)):
+                old = slice(old_offsets[order[i]], old_offsets[order[i] + 1])
+                new = slice(offsets[i], offsets[i + 1])
+                assert np.array_equal(ids[new], rank[old_ids[old]])
+                assert np.array_equal(weights[new], old_weights[old])
+
+            if "to_upper" in b:
+                upper_order, upper_rank = maps[l + 1]
+                assert np.array_equal(a["to_upper"],
+                                      remap(b["to_upper"][upper_order], rank))
+                assert np.array_equal(a["to_lower"],
+                                      remap(b["to_lower"][order], upper_rank))
+
+        rank = maps[0][1]
+        assert np.array_equal(result["faces"], rank[plain["faces"]])
+        assert np.array_equal(np.sort(result["creases"]),
+                              np.sort(rank[plain["creases"]]))
+        if crease_angle > 0:
+            assert len(plain["creases"]) > 0
+
+
+def graded_strip(n):
+    """
+    Strip of n quads whose widths grow linearly, so the collapse scores
+    decrease along the strip and the matching proceeds one edge at a time.
+    """
+    x = np.cumsum(np.arange(n + 1)) * 0.01
+    zeros = np.zeros(n + 1)
+    vertices = np.concatenate([np.stack([x, zeros, zeros], axis=-1),
+                               np.stack([x, zeros + 1, zeros], axis=-1)])
+    a = np.arange(n)
+    b = a + n + 1
+    faces = np.concatenate([np.stack([a, a + 1, b + 1], axis=-1),
+                            np.stack([a, b + 1, b], axis=-1)])
+    return vertices.astype(np.float32), faces.astype(np.int32)
+
+
+class TestRadixHierarchy:
+    """build_hierarchy_radix() against the greedy MultiResolutionHierarchy::build()."""
+
+    @pytest.mark.parametrize("mesh", ["folded", "dirty", "strip"])
+    def test_radix_matches_greedy(self, kernels, mesh):
+        """Test that every level matches the greedy hierarchy."""
+        if mesh == "strip":
+            vertices, faces = graded_strip(200)
+        else:
+            vertices, faces = folded_grid(40) if mesh == "folded" else dirty_grid(40)
+
+        result = kernels.build_hierarchy(vertices, faces, radix=True)
+        expected = kernels.build_hierarchy(vertices, faces)
+
+        levels = expected["levels"]
+        assert len(result["levels"]) == len(levels) > 2
+        for l, (a, b) in enumerate(zip(result["levels"], levels)):
+            assert len(a["A"]) == len(b["A"]), l
+            for name in ("to_upper", "to_lower"):
+                assert (name in a) == (name in b), (l, name)
+                if name in b:
+                    assert np.array_equal(a[name], b[name]), (l, name)
+            for name in ("V", "N", "A"):
+                assert np.array_equal(a[name], b[name]), (l, name)
+            for array, old in zip(a["adjacency"], b["adjacency"]):
+                assert np.array_equal(array, old), l
+            assert len(a["phases"]) == len(b["phases"]), l
+            for phase, old in zip(a["phases"], b["phases"]):
+                assert np.array_equal(phase, old), l
+
+    def test_radix_thread_count(self, kernels, serial):
+        """Test that the radix hierarchy does not depend on the thread count."""
+        vertices, faces = graded_strip(200)
+
+        single = serial(kernels.build_hierarchy, vertices, faces, radix=True)
+        result = kernels.build_hierarchy(vertices, faces, radix=True)
+
+        assert len(result["levels"]) == len(single["levels"])
+        for l, (a, b) in enumerate(zip(result["levels"], single["levels"])):
+            assert np.array_equal(a["V"], b["V"]), l
+            if "to_upper" in b:
+                assert np.array_equal(a["to_upper"], b["to_upper"]), l
+
+
+class TestNormals:
+    """generate_normals_parallel() against the upstream normals."""
+
+    @pytest.mark.parametrize("mesh", ["folded", "dirty"])
+    def test_smooth_normals_match_upstream(self, kernels, mesh):
+        """Test that smooth normals match generate_smooth_normals()."""
+        vertices, faces = folded_grid(30) if mesh == "folded" else dirty_grid(30)
+
+        normals, creases = kernels.normals(vertices, faces)
+        expected, _ = kernels.normals(vertices, faces, parallel=False)
+
+        assert len(creases) == 0
+        assert normals.shape == expected.shape
+        assert np.allclose(normals, expected, atol=1e-5)
+
+    def test_crease_normals(self, kernels):
+        """Test crease normals: smooth away from the fold, bisector on it."""
+        vertices, faces = folded_grid(30)
+
+        normals, creases = kernels.normals(vertices, faces, 45.0)
+        smooth, _ = kernels.normals(vertices, faces)
+        upstream, upstream_creases = kernels.normals(vertices, faces, 45.0, parallel=False)
+
+        fold = np.flatnonzero(vertices[:, 0] == 15.0)
+        assert np.array_equal(creases, fold)
+
+        away = np.setdiff1d(np.arange(len(vertices)), np.union1d(creases, upstream_creases))
+        assert len(away) > len(vertices) // 2
+        assert np.allclose(normals[away], smooth[away], atol=1e-6)
+        assert np.allclose(normals[away], upstream[away], atol=1e-5)
+
+        # The planes z = |x - 15| meet at a right angle along the fold
+        assert np.allclose(np.linalg.norm(normals[fold], axis=1), 1.0, atol=1e-5)
+        assert np.all(np.abs(normals[fold, 0]) < 0.05)
+        assert np.all(normals[fold, 2] > 0.9)
+
+
+class TestMeshStats:
+    """The fused statistics and dual area passes against the upstream ones."""
+
+    @pytest.mark.parametrize("mesh", ["folded", "dirty"])
+    def test_mesh_stats_match_upstream(self, kernels, mesh):
+        """Test that all statistics match compute_mesh_stats()."""
+        vertices, faces = folded_grid(40) if mesh == "folded" else dirty_grid(40)
+
+        result = kernels.mesh_stats(vertices, faces, parallel=True)
+        expected = kernels.mesh_stats(vertices, faces, parallel=False)
+
+        for name in ("surface_area", "average_edge_length", "maximum_edge_length"):
+            assert result[name] == pytest.approx(expected[name], rel=1e-5), name
+        assert np.allclose(result["weighted_center"], expected["weighted_center"],
+                           rtol=1e-5, atol=1e-5)
+        assert np.array_equal(result["bbox_min"], expected["bbox_min"])
+        assert np.array_equal(result["bbox_max"], expected["bbox_max"])
+        assert result["face_areas"].sum() == pytest.approx(expected["surface_area"], rel=1e-5)
+
+    def test_mesh_stats_thread_count(self, kernels, serial):
+        """Test that the fused pass does not depend on the thread count."""
+        vertices, faces = folded_grid(80)
+
+        single = serial(kernels.mesh_stats, vertices, faces, parallel=True)
+        result = kernels.mesh_stats(vertices, faces, parallel=True)
+
+        for name, value in single.items():
+            assert np.array_equal(result[name], value), name
+
+    @pytest.mark.parametrize("mesh", ["folded", "dirty"])
+    @pytest.mark.parametrize("cached", [False, True])
+    def test_dual_areas_match_upstream(self, kernels, mesh, cached):
+        """Test that dual areas match compute_dual_vertex_areas()."""
+        vertices, faces = folded_grid(40) if mesh == "folded" else dirty_grid(40)
+
+        areas = kernels.dual_areas(vertices, faces, parallel=True,
+                                   cached_face_areas=cached)
+        expected = kernels.dual_areas(vertices, faces, parallel=False)
+
+        assert np.allclose(areas, expected, rtol=1e-5, atol=1e-6)
+        if mesh == "dirty":
+            _, _, _, non_manifold = kernels.build_dedge(vertices, faces, parallel=True)
+            assert np.all(areas[non_manifold] == 0)
+            assert areas[-1] == 0
+
+
+
+class TestConstraints:
+    """restrict_constraints() against the upstream propagateConstraints()."""
+
+    @pytest.mark.parametrize("mesh", ["grid", "folded"])
+    @pytest.mark.parametrize("rosy,posy", [(4, 4), (6, 3), (2, 4)])
+    def test_constraints_match_upstream(self, kernels, mesh, rosy, posy):
+        """Test that boundary constraints restrict as propagateConstraints()."""
+        vertices, faces = grid(40) if mesh == "grid" else folded_grid(40)
+
+        levels = kernels.constraints(vertices, faces, rosy, posy)
+        expected = kernels.constraints(vertices, faces, rosy, posy, parallel=False)
+
+        assert len(levels) == len(expected) > 2
+        for l, (level, upstream) in enumerate(zip(levels, expected)):
+            for name in ("CQw", "COw"):
+                assert np.array_equal(level[name], upstream[name]), (l, name)
+            for name in ("CQ", "CO"):
+                assert np.allclose(level[name], upstream[name], atol=1e-5), (l, name)
+
+        # Every level keeps constrained vertices along the boundary
+        for level in levels:
+            assert np.count_nonzero(level["CQw"]) > 0
+            assert np.count_nonzero(level["COw"]) > 0
+        boundary = np.flatnonzero(levels[0]["CQw"])
+        assert len(boundary) == 4 * 40
+
+
+class TestSolverControl:
+    """Cancellation of the solver schedules of solver.cpp."""
+
+    @pytest.mark.parametrize("field", ["orientation", "position"])
+    def test_solve_completes(self, kernels, field):
+        """Test that an untouched control lets the schedule finish."""
+        vertices, faces = grid(20)
+        control = get_backend("float32").SolverControl()
+
+        assert kernels.solve_field(vertices, faces, control, field)
+        assert control.sweeps > 0
+        assert control.sweeps % 6 == 0
+
+    @pytest.mark.parametrize("field", ["orientation", "position"])
+    def test_cancel_before_solve(self, kernels, field):
+        """Test that a cancelled control stops before the first sweep."""
+        vertices, faces = grid(20)
+        control = get_backend("float32").SolverControl()
+        control.cancel()
+
+        assert not kernels.solve_field(vertices, faces, control, field)
+        assert control.sweeps == 0
+
+    @pytest.mark.parametrize("field", ["orientation", "position"])
+    def test_cancel_from_thread(self, kernels, field):
+        """Test cancelling a running schedule from another thread."""
+        vertices, faces = grid(20)
+        control = get_backend("float32").SolverControl()
+        result = []
+
+        # Far more sweeps than the schedule could finish before the cancel
+        job = threading.Thread(target=lambda: result.append(
+            kernels.solve_field(vertices, faces, control, field, max_iterations=10**6)))
+        job.start()
+        deadline = time.monotonic() + 60
+        while control.sweeps == 0 and time.monotonic() < deadline:
+            time.sleep(0.01)
+        control.cancel()
+        job.join(60)
+
+        assert not job.is_alive()
+        assert result == [False]
+        assert control.sweeps > 0
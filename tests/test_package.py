@@ -12,6 +12,7 @@ def test_package_imports():
     
     assert hasattr(pyinstantmeshes, 'remesh')
     assert hasattr(pyinstantmeshes, 'remesh_file')
+    assert hasattr(pyinstantmeshes, 'remesh_tiled')
     assert hasattr(pyinstantmeshes, '__version__')
     assert pyinstantmeshes.__version__ == "0.1.0"
 
@@ -23,6 +24,7 @@ def test_package_all():
     assert hasattr(pyinstantmeshes, '__all__')
     assert 'remesh' in pyinstantmeshes.__all__
     assert 'remesh_file' in pyinstantmeshes.__all__
+    assert 'remesh_tiled' in pyinstantmeshes.__all__
 
 
 def test_module_docstring():
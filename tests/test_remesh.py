@@ -2,9 +2,13 @@
 Tests for the remesh function.
 """
 
+import importlib
+import threading
+import time
 import pytest
 import numpy as np
 import pyinstantmeshes
+from pyinstantmeshes._backend import get_backend
 
 
 class TestRemeshBasic:
@@ -204,6 +208,278 @@ class TestRemeshParameters:
         assert len(output2_f) > 0
         # Results should have similar vertex counts (within reasonable range)
         assert abs(len(output1_v) - len(output2_v)) < 20
+    
+    def test_remesh_parallel_subdivide(self, simple_cube):
+        """Test remesh with parallel subdivision of a coarse input."""
+        vertices, faces = simple_cube
+        
+        output_vertices, output_faces = pyinstantmeshes.remesh(
+            vertices, faces, target_edge_length=0.1, parallel_subdivide=True,
+            deterministic=True
+        )
+        
+        assert len(output_vertices) > 0
+        assert len(output_faces) > 0
+        assert np.all(np.isfinite(output_vertices))
+    
+    @pytest.mark.parametrize("ordering", ["morton", "hilbert", "rcm"])
+    def test_remesh_vertex_ordering(self, simple_cube, ordering):
+        """Test remesh with each vertex ordering."""
+        vertices, faces = simple_cube
+        
+        output_vertices, output_faces = pyinstantmeshes.remesh(
+            vertices, faces, target_vertex_count=50, vertex_ordering=ordering,
+            deterministic=True
+        )
+        
+        assert len(output_vertices) > 0
+        assert len(output_faces) > 0
+        assert np.all(output_faces < len(output_vertices))
+    
+    def test_remesh_color_contiguous(self, simple_cube):
+        """Test remesh with a color-contiguous hierarchy layout."""
+        vertices, faces = simple_cube
+        
+        output_vertices, output_faces = pyinstantmeshes.remesh(
+            vertices, faces, target_vertex_count=50, color_contiguous=True,
+            crease_angle=30.0, deterministic=True
+        )
+        
+        assert len(output_vertices) > 0
+        assert len(output_faces) > 0
+        assert np.all(output_faces < len(output_vertices))
+    
+    def test_remesh_solver_tolerance(self, simple_cube):
+        """Test remesh with the residual-driven solver schedule."""
+        vertices, faces = simple_cube
+        
+        output_vertices, output_faces, stats = pyinstantmeshes.remesh(
+            vertices, faces, target_vertex_count=50, solver_tolerance=1e-3,
+            solver_max_iterations=4, return_stats=True, deterministic=True
+        )
+        
+        assert len(output_vertices) > 0
+        assert np.all(output_faces < len(output_vertices))
+        for field in ("orientation", "position"):
+            iterations = stats[field]["iterations"]
+            assert len(iterations) > 0
+            assert all(1 <= count <= 4 for count in iterations)
+            assert [len(e) for e in stats[field]["energy"]] == iterations
+    
+    def test_remesh_workers(self, simple_cube):
+        """Test remesh with several worker processes."""
+        vertices, faces = simple_cube
+        
+        output_vertices, output_faces = pyinstantmeshes.remesh(
+            vertices, faces, target_vertex_count=200, workers=2,
+            deterministic=True
+        )
+        
+        assert output_vertices.dtype == np.float32
+        assert output_faces.dtype == np.int32
+        assert len(output_faces) > 0
+        assert np.all(output_faces < len(output_vertices))
+    
+    def test_remesh_precision_float64(self, simple_cube):
+        """Test remesh with the double precision backend."""
+        vertices, faces = simple_cube
+        
+        output_vertices, output_faces = pyinstantmeshes.remesh(
+            vertices.astype(np.float64), faces, target_vertex_count=50,
+            precision="float64", deterministic=True
+        )
+        
+        assert output_vertices.dtype == np.float64
+        assert output_faces.dtype == np.int32
+        assert len(output_faces) > 0
+        assert np.all(output_faces < len(output_vertices))
+    
+    @pytest.mark.parametrize("name", ["_pyinstantmeshes", "_pyinstantmeshes_f64"])
+    def test_backend_module_imports(self, name):
+        """Test that each backend module imports, without the get_backend() message."""
+        module = importlib.import_module("pyinstantmeshes." + name)
+        
+        assert hasattr(module, "remesh")
+    
+    def test_remesh_numa_interleave(self, simple_cube):
+        """Test remesh with the hierarchy interleaved over NUMA nodes."""
+        vertices, faces = simple_cube
+        
+        output_vertices, output_faces = pyinstantmeshes.remesh(
+            vertices, faces, target_vertex_count=50, numa_interleave=True,
+            color_contiguous=True, deterministic=True
+        )
+        
+        assert len(output_vertices) > 0
+        assert len(output_faces) > 0
+        assert np.all(output_faces < len(output_vertices))
+    
+    def test_remesh_huge_pages(self, simple_cube):
+        """Test remesh with the hierarchy in transparent huge pages."""
+        vertices, faces = simple_cube
+        
+        output_vertices, output_faces, stats = pyinstantmeshes.remesh(
+            vertices, faces, target_vertex_count=50, huge_pages=True,
+            return_stats=True, deterministic=True
+        )
+        
+        assert len(output_vertices) > 0
+        assert np.all(output_faces < len(output_vertices))
+        assert stats["huge_pages"] >= 0
+    
+    def test_remesh_parallel_normals(self, simple_tetrahedron):
+        """Test that parallel smooth normals give the upstream remesh result.
+        
+        The normals agree up to rounding (see test_kernels.py), which the
+        solver may amplify, so the meshes are compared by size and extent.
+        """
+        vertices, faces = simple_tetrahedron
+        
+        output_vertices, output_faces = pyinstantmeshes.remesh(
+            vertices, faces, target_vertex_count=50, parallel_normals=True,
+            deterministic=True
+        )
+        expected_vertices, expected_faces = pyinstantmeshes.remesh(
+            vertices, faces, target_vertex_count=50, parallel_normals=False,
+            deterministic=True
+        )
+        
+        assert abs(len(output_faces) - len(expected_faces)) <= 0.1 * len(expected_faces)
+        assert np.allclose(output_vertices.min(axis=0), expected_vertices.min(axis=0), atol=0.05)
+        assert np.allclose(output_vertices.max(axis=0), expected_vertices.max(axis=0), atol=0.05)
+    
+    def test_remesh_radix_downsample(self, simple_cube):
+        """Test remesh with a radix-sorted hierarchy build."""
+        vertices, faces = simple_cube
+        
+        output_vertices, output_faces = pyinstantmeshes.remesh(
+            vertices, faces, target_vertex_count=50, radix_downsample=True,
+            deterministic=True
+        )
+        
+        assert len(output_faces) > 0
+        assert np.all(np.isfinite(output_vertices))
+        assert np.all(output_faces < len(output_vertices))
+    
+    def test_remesh_direct_solver(self, simple_cube):
+        """Test remesh with the fixed schedule on the calling thread."""
+        vertices, faces = simple_cube
+        
+        output_vertices, output_faces, stats = pyinstantmeshes.remesh(
+            vertices, faces, target_vertex_count=50, direct_solver=True,
+            return_stats=True, deterministic=True
+        )
+        
+        assert len(output_faces) > 0
+        assert np.all(output_faces < len(output_vertices))
+        assert stats["orientation"]["energy"] == []
+    
+    def test_remesh_perf_counters(self, simple_cube):
+        """Test per-stage hardware counters, which may be unavailable."""
+        vertices, faces = simple_cube
+        
+        output_vertices, output_faces, stats = pyinstantmeshes.remesh(
+            vertices, faces, target_vertex_count=50, perf_counters=True,
+            return_stats=True
+        )
+        
+        assert len(output_faces) > 0
+        assert "optimize_positions" in stats["perf"]
+        for counters in stats["perf"].values():
+            assert set(counters) <= {"cycles", "instructions", "llc_misses", "dtlb_misses"}
+    
+    def test_prepare_mesh(self, simple_cube):
+        """Test remeshing a prepared mesh with several targets."""
+        vertices, faces = simple_cube
+        
+        mesh = pyinstantmeshes.prepare_mesh(vertices, faces)
+        assert mesh.vertex_count == len(vertices)
+        
+        # The cached statistics match the upstream compute_mesh_stats()
+        expected = get_backend("float32")._testing.mesh_stats(vertices, faces, parallel=False)
+        for name in ("surface_area", "average_edge_length", "maximum_edge_length"):
+            assert mesh.stats[name] == pytest.approx(expected[name], rel=1e-5)
+        assert np.array_equal(mesh.stats["bbox_min"], expected["bbox_min"])
+        assert np.array_equal(mesh.stats["bbox_max"], expected["bbox_max"])
+        
+        coarse_vertices, coarse_faces = mesh.remesh(
+            target_vertex_count=20, deterministic=True
+        )
+        fine_vertices, fine_faces = mesh.remesh(
+            target_vertex_count=100, deterministic=True
+        )
+        direct_vertices, direct_faces = pyinstantmeshes.remesh(
+            vertices, faces, target_vertex_count=100, deterministic=True
+        )
+        
+        assert np.all(coarse_faces < len(coarse_vertices))
+        assert len(fine_vertices) > len(coarse_vertices)
+        assert np.array_equal(fine_faces, direct_faces)
+    
+    def test_remesh_face_format_quads(self, simple_cube):
+        """Test remesh returning the extracted quads without triangulation."""
+        vertices, faces = simple_cube
+        
+        output_vertices, output_faces = pyinstantmeshes.remesh(
+            vertices, faces, target_vertex_count=50, pure_quad=True,
+            face_format="quads", deterministic=True
+        )
+        
+        assert output_faces.dtype == np.int32
+        assert output_faces.shape[1] == 4
+        assert len(output_faces) > 0
+        assert np.all(output_faces < len(output_vertices))
+    
+    def test_remesh_face_format_triangles(self, simple_cube):
+        """Test that 'triangles' splits and compacts the extracted quads."""
+        vertices, faces = simple_cube
+        options = dict(target_vertex_count=50, deterministic=True)
+        
+        output_vertices, output_faces = pyinstantmeshes.remesh(
+            vertices, faces, face_format="triangles", **options
+        )
+        quad_vertices, quads = pyinstantmeshes.remesh(
+            vertices, faces, face_format="quads", **options
+        )
+        
+        # (a, b, c, d) -> (a, b, c), (d, a, c); triangles repeat their last index
+        expected = []
+        for a, b, c, d in quads:
+            expected.append((a, b, c))
+            if d != c:
+                expected.append((d, a, c))
+        expected = np.array(expected)
+        used, first = np.unique(expected.ravel(), return_index=True)
+        used = used[np.argsort(first)]
+        rank = np.empty(len(quad_vertices), dtype=np.int64)
+        rank[used] = np.arange(len(used))
+        
+        assert np.array_equal(output_faces, rank[expected])
+        assert np.array_equal(output_vertices, quad_vertices[used])
+        
+        # Vertices are numbered by first use, and all of them are used
+        flat = output_faces.ravel()
+        _, first = np.unique(flat, return_index=True)
+        assert np.array_equal(flat[np.sort(first)], np.arange(len(output_vertices)))
+    
+    def test_remesh_face_format_csr(self, simple_cube):
+        """Test remesh returning faces as an offsets/indices pair."""
+        vertices, faces = simple_cube
+        
+        output_vertices, (offsets, indices) = pyinstantmeshes.remesh(
+            vertices, faces, target_vertex_count=50, face_format="csr",
+            deterministic=True
+        )
+        _, quads = pyinstantmeshes.remesh(
+            vertices, faces, target_vertex_count=50, face_format="quads",
+            deterministic=True
+        )
+        
+        sizes = np.diff(offsets)
+        assert offsets[0] == 0 and offsets[-1] == len(indices)
+        assert len(sizes) == len(quads)
+        assert np.all((sizes == 3) | (sizes == 4))
+        assert np.all(indices < len(output_vertices))
 
 
 class TestRemeshValidation:
@@ -240,6 +516,40 @@ class TestRemeshValidation:
         
         with pytest.raises(RuntimeError, match="Faces must be a Nx3 or Nx4 array"):
             pyinstantmeshes.remesh(vertices, faces)
+    
+    def test_remesh_invalid_vertex_ordering(self, simple_cube):
+        """Test remesh with an unknown vertex ordering."""
+        vertices, faces = simple_cube
+        
+        with pytest.raises(ValueError, match="Unknown vertex ordering"):
+            pyinstantmeshes.remesh(vertices, faces, vertex_ordering="zorder")
+        with pytest.raises(ValueError, match="Unknown vertex ordering"):
+            pyinstantmeshes.remesh_sweep(
+                vertices, faces, {"vertex_ordering": ["hilbert", "zorder"]}
+            )
+    
+    def test_remesh_invalid_solver_max_iterations(self, simple_cube):
+        """Test remesh with a non-positive sweep cap."""
+        vertices, faces = simple_cube
+        
+        with pytest.raises(ValueError, match="solver_max_iterations"):
+            pyinstantmeshes.remesh(
+                vertices, faces, solver_tolerance=1e-3, solver_max_iterations=0
+            )
+    
+    def test_remesh_invalid_workers(self, simple_cube):
+        """Test remesh with a non-positive number of workers."""
+        vertices, faces = simple_cube
+        
+        with pytest.raises(ValueError, match="workers"):
+            pyinstantmeshes.remesh(vertices, faces, workers=0)
+    
+    def test_remesh_invalid_precision(self, simple_cube):
+        """Test remesh with an unknown precision."""
+        vertices, faces = simple_cube
+        
+        with pytest.raises(ValueError, match="Unknown precision"):
+            pyinstantmeshes.remesh(vertices, faces, precision="float16")
 
 
 class TestRemeshOutput:
@@ -290,3 +600,203 @@ class TestRemeshOutput:
         )
         
         assert np.all(np.isfinite(output_vertices))
+
+
+class TestRemeshLogging:
+    """Test routing of the progress output."""
+    
+    def test_remesh_silent_by_default(self, simple_tetrahedron, capfd):
+        """Test that remesh writes nothing to stdout without a logger."""
+        vertices, faces = simple_tetrahedron
+        
+        pyinstantmeshes.remesh(vertices, faces, target_vertex_count=50,
+                               deterministic=True)
+        
+        assert capfd.readouterr().out == ""
+    
+    def test_remesh_set_logger(self, simple_tetrahedron, caplog):
+        """Test that set_logger forwards the progress output as records."""
+        vertices, faces = simple_tetrahedron
+        
+        pyinstantmeshes.set_logger("pyinstantmeshes.test")
+        try:
+            with caplog.at_level("INFO", logger="pyinstantmeshes.test"):
+                pyinstantmeshes.remesh(vertices, faces, target_vertex_count=50,
+                                       deterministic=True)
+        finally:
+            pyinstantmeshes.set_logger(None)
+        
+        records = [r for r in caplog.records if r.name == "pyinstantmeshes.test"]
+        assert len(records) > 0
+        assert all("\n" not in r.getMessage() for r in records)
+
+
+class TestRemeshTracing:
+    """Test the timeline export."""
+    
+    def test_remesh_trace(self, simple_cube, tmp_path):
+        """Test that a traced remesh produces a loadable Chrome trace."""
+        vertices, faces = simple_cube
+        path = tmp_path / "trace.json"
+        
+        pyinstantmeshes.start_trace()
+        try:
+            pyinstantmeshes.remesh(vertices, faces, target_vertex_count=50,
+                                   deterministic=True)
+        finally:
+            trace = pyinstantmeshes.stop_trace(str(path))
+        
+        events = [e for e in trace["traceEvents"] if e["ph"] == "X"]
+        names = {e["name"] for e in events}
+        assert "remesh_pipeline" in names
+        assert "build_hierarchy" in names
+        assert all(e["dur"] >= 0 for e in events)
+        assert path.stat().st_size > 0
+
+
+class TestRemeshThreads:
+    """Test the thread count control."""
+    
+    def test_remesh_single_thread(self, simple_cube):
+        """Test that a job runs with a limit of one thread."""
+        vertices, faces = simple_cube
+        
+        pyinstantmeshes.set_num_threads(1)
+        try:
+            assert pyinstantmeshes.get_num_threads() == 1
+            output_vertices, output_faces = pyinstantmeshes.remesh(
+                vertices, faces, target_vertex_count=50, deterministic=True
+            )
+        finally:
+            pyinstantmeshes.set_num_threads(None)
+        
+        assert len(output_faces) > 0
+        assert pyinstantmeshes.get_num_threads() >= 1
+
+
+class TestSolverControl:
+    """Test cancellation and progress of a job through a SolverControl."""
+    
+    def test_control_matches_direct_solver(self, simple_cube):
+        """Test that a job with a control counts its sweeps and runs as direct_solver."""
+        vertices, faces = simple_cube
+        control = pyinstantmeshes.solver_control()
+        
+        output_vertices, output_faces = pyinstantmeshes.remesh(
+            vertices, faces, target_vertex_count=50, deterministic=True,
+            solver_control=control
+        )
+        expected_vertices, expected_faces = pyinstantmeshes.remesh(
+            vertices, faces, target_vertex_count=50, deterministic=True,
+            direct_solver=True
+        )
+        
+        assert np.array_equal(output_vertices, expected_vertices)
+        assert np.array_equal(output_faces, expected_faces)
+        # Six sweeps per level for each of the two fields
+        assert control.sweeps > 0
+        assert control.sweeps % 12 == 0
+        assert not control.cancelled
+    
+    def test_cancel_before_solve(self, simple_cube):
+        """Test that a cancelled control stops the job before its first sweep."""
+        vertices, faces = simple_cube
+        control = pyinstantmeshes.solver_control()
+        control.cancel()
+        
+        with pytest.raises(RuntimeError, match="cancelled"):
+            pyinstantmeshes.remesh(vertices, faces, target_vertex_count=50,
+                                   solver_control=control)
+        assert control.sweeps == 0
+    
+    def test_cancel_running_job(self, simple_cube):
+        """Test cancelling a job from another thread while it solves."""
+        vertices, faces = simple_cube
+        control = pyinstantmeshes.solver_control()
+        errors = []
+        
+        def run():
+            try:
+                # Far more sweeps than the job could finish before the cancel
+                pyinstantmeshes.remesh(vertices, faces, target_vertex_count=50,
+                                       solver_max_iterations=10**6,
+                                       solver_control=control)
+            except RuntimeError as error:
+                errors.append(error)
+        
+        job = threading.Thread(target=run)
+        job.start()
+        deadline = time.monotonic() + 60
+        while control.sweeps == 0 and time.monotonic() < deadline:
+            time.sleep(0.01)
+        control.cancel()
+        job.join(60)
+        
+        assert not job.is_alive()
+        assert control.sweeps > 0
+        assert len(errors) == 1
+        assert "cancelled" in str(errors[0])
+    
+    def test_control_requires_single_worker(self, simple_cube):
+        """Test that a control is rejected for partitioned remeshing."""
+        vertices, faces = simple_cube
+        with pytest.raises(TypeError):
+            pyinstantmeshes.remesh(vertices, faces, workers=2,
+                                   solver_control=pyinstantmeshes.solver_control())
+
+
+class TestRemeshSweep:
+    """Test parameter sweeps with shared preprocessing."""
+    
+    def test_remesh_sweep(self, simple_cube):
+        """Test that every combination is run and preprocessing is shared."""
+        vertices, faces = simple_cube
+        
+        results, timings = pyinstantmeshes.remesh_sweep(
+            vertices, faces,
+            {"posy": [3, 4], "target_vertex_count": [30, 60]},
+            deterministic=True
+        )
+        
+        assert len(results) == 4
+        assert [r["params"]["posy"] for r in results] == [3, 3, 4, 4]
+        for result in results:
+            assert len(result["faces"]) > 0
+            assert np.all(result["faces"] < len(result["vertices"]))
+            assert result["seconds"] >= 0
+        assert timings["groups"] <= 2
+    
+    def test_remesh_sweep_matches_remesh(self, simple_cube):
+        """Test that every job equals a standalone direct-solver remesh()."""
+        vertices, faces = simple_cube
+        common = dict(target_vertex_count=60, deterministic=True)
+        
+        results, _ = pyinstantmeshes.remesh_sweep(
+            vertices, faces, {"rosy": [4, 6], "posy": [3, 4]}, **common
+        )
+        
+        assert len(results) == 4
+        for result in results:
+            expected_vertices, expected_faces = pyinstantmeshes.remesh(
+                vertices, faces, direct_solver=True, **result["params"], **common
+            )
+            assert np.array_equal(result["vertices"], expected_vertices), result["params"]
+            assert np.array_equal(result["faces"], expected_faces), result["params"]
+    
+    def test_remesh_sweep_crease_groups(self, simple_cube):
+        """Test that each crease angle gets its own preprocessing."""
+        vertices, faces = simple_cube
+        mesh = pyinstantmeshes.prepare_mesh(vertices, faces)
+        
+        results, timings = pyinstantmeshes.remesh_sweep(
+            mesh, None, {"crease_angle": [-1, 30]}, target_vertex_count=50
+        )
+        
+        assert timings["groups"] == 2
+        assert results[0]["group"] != results[1]["group"]
+    
+    def test_remesh_sweep_invalid_parameter(self, simple_cube):
+        """Test that unsupported parameters are rejected."""
+        vertices, faces = simple_cube
+        with pytest.raises(TypeError):
+            pyinstantmeshes.remesh_sweep(vertices, faces, {"unknown": [1]})
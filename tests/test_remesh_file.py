@@ -5,6 +5,7 @@ Tests for the remesh_file function.
 import pytest
 import numpy as np
 import pyinstantmeshes
+from pyinstantmeshes._backend import get_backend
 import os
 
 
@@ -101,6 +102,83 @@ class TestRemeshFileParameters:
         assert len(output2_f) > 0
         # Results should have similar vertex counts (within reasonable range)
         assert abs(len(output1_v) - len(output2_v)) < 20
+    
+    def test_remesh_file_precision_float64(self, temp_obj_file, tmp_path):
+        """Test remesh_file with the double precision backend."""
+        output_path = str(tmp_path / "output.obj")
+        
+        output_vertices, output_faces = pyinstantmeshes.remesh_file(
+            temp_obj_file, output_path, target_vertex_count=50,
+            precision="float64", deterministic=True
+        )
+        
+        assert output_vertices.dtype == np.float64
+        assert len(output_faces) > 0
+    
+    def test_remesh_file_without_arrays(self, temp_obj_file, tmp_path):
+        """Test remesh_file that only writes the output file."""
+        output_path = str(tmp_path / "output.obj")
+        
+        result = pyinstantmeshes.remesh_file(
+            temp_obj_file, output_path, target_vertex_count=50,
+            return_arrays=False, deterministic=True
+        )
+        
+        assert result is None
+        assert os.path.getsize(output_path) > 0
+    
+    def test_remesh_file_background_write(self, temp_obj_file, tmp_path):
+        """Test remesh_file that writes the output file in the background."""
+        output_path = str(tmp_path / "output.obj")
+        
+        output_vertices, output_faces, handle = pyinstantmeshes.remesh_file(
+            temp_obj_file, output_path, target_vertex_count=50,
+            background_write=True, deterministic=True
+        )
+        
+        assert len(output_faces) > 0
+        assert handle.path == output_path
+        assert handle.wait()
+        assert handle.done()
+        with open(output_path) as f:
+            lines = f.read().splitlines()
+        assert sum(line.startswith("v ") for line in lines) == len(output_vertices)
+    
+    def test_remesh_file_background_write_owns_mesh(self, temp_obj_file, tmp_path):
+        """Test that changing the returned arrays does not affect the file."""
+        output_path = str(tmp_path / "output.obj")
+        
+        output_vertices, output_faces, handle = pyinstantmeshes.remesh_file(
+            temp_obj_file, output_path, target_vertex_count=50,
+            face_format="quads", background_write=True, deterministic=True
+        )
+        expected_vertices = output_vertices.copy()
+        expected_faces = output_faces.copy()
+        output_vertices[:] = 0.0
+        output_faces[:] = 0
+        
+        assert handle.wait()
+        with open(output_path) as f:
+            lines = f.read().splitlines()
+        vertices = np.array([line.split()[1:] for line in lines if line.startswith("v ")],
+                            dtype=np.float64).astype(np.float32)
+        faces = [[int(i) - 1 for i in line.split()[1:]]
+                 for line in lines if line.startswith("f ")]
+        assert np.array_equal(vertices, expected_vertices)
+        assert len(faces) == len(expected_faces)
+        for face, quad in zip(faces, expected_faces):
+            assert face == list(quad[:len(face)])
+    
+    def test_remesh_file_background_write_requires_obj(self, temp_obj_file, tmp_path):
+        """Test that background_write rejects outputs other than OBJ."""
+        output_path = str(tmp_path / "output.ply")
+        
+        with pytest.raises(ValueError, match=r"\.obj"):
+            pyinstantmeshes.remesh_file(
+                temp_obj_file, output_path, target_vertex_count=50,
+                background_write=True
+            )
+        assert not os.path.exists(output_path)
 
 
 class TestRemeshFileValidation:
@@ -114,6 +192,16 @@ class TestRemeshFileValidation:
         # Should raise an error when input file doesn't exist
         with pytest.raises(Exception):  # Could be RuntimeError or other exception
             pyinstantmeshes.remesh_file(input_path, output_path, target_vertex_count=50)
+    
+    def test_remesh_file_invalid_vertex_ordering(self, temp_obj_file, tmp_path):
+        """Test remesh_file with an unknown vertex ordering."""
+        output_path = str(tmp_path / "output.obj")
+        
+        with pytest.raises(ValueError, match="Unknown vertex ordering"):
+            pyinstantmeshes.remesh_file(
+                temp_obj_file, output_path, vertex_ordering="zorder"
+            )
+        assert not os.path.exists(output_path)
 
 
 class TestRemeshFileOutput:
@@ -180,3 +268,15 @@ class TestRemeshFileOutput:
         assert len(content) > 0
         assert 'v ' in content  # Should have vertices
         assert 'f ' in content  # Should have faces
+    
+    def test_remesh_file_arrays_match_output_file(self, temp_obj_file, tmp_path):
+        """Test that the returned arrays equal the output file read back."""
+        output_path = str(tmp_path / "output.obj")
+        
+        output_vertices, output_faces = pyinstantmeshes.remesh_file(
+            temp_obj_file, output_path, target_vertex_count=50, deterministic=True
+        )
+        loaded_vertices, loaded_faces = get_backend("float32")._testing.load_mesh(output_path)
+        
+        assert np.array_equal(output_vertices, loaded_vertices)
+        assert np.array_equal(output_faces, loaded_faces)
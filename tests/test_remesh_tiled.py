@@ -0,0 +1,133 @@
+"""
+Tests for the remesh_tiled function.
+"""
+
+import pytest
+import numpy as np
+import pyinstantmeshes
+from pyinstantmeshes import _partition
+
+
+@pytest.fixture
+def plane_grid():
+    """Create a triangulated 40x40 grid on the unit square."""
+    n = 40
+    x, y = np.meshgrid(np.linspace(0.0, 1.0, n + 1), np.linspace(0.0, 1.0, n + 1))
+    vertices = np.stack([x.ravel(), y.ravel(), np.zeros(x.size)], axis=1).astype(np.float32)
+    
+    index = np.arange((n + 1) ** 2).reshape(n + 1, n + 1)
+    a, b = index[:-1, :-1].ravel(), index[:-1, 1:].ravel()
+    c, d = index[1:, 1:].ravel(), index[1:, :-1].ravel()
+    faces = np.concatenate([np.stack([a, b, c], axis=1),
+                            np.stack([a, c, d], axis=1)]).astype(np.int32)
+    
+    return vertices, faces
+
+
+class TestRemeshTiled:
+    """Test tiled remeshing."""
+    
+    def test_remesh_tiled_single_tile(self, plane_grid):
+        """Test that a mesh smaller than a tile is remeshed in one piece."""
+        vertices, faces = plane_grid
+        
+        output_vertices, output_faces = pyinstantmeshes.remesh_tiled(
+            vertices, faces, target_edge_length=0.1, deterministic=True
+        )
+        
+        assert output_vertices.dtype == np.float32
+        assert output_faces.dtype == np.int32
+        assert len(output_faces) > 0
+        assert np.all(output_faces < len(output_vertices))
+    
+    def test_remesh_tiled_multiple_tiles(self, plane_grid):
+        """Test remeshing with several tiles and welded seams."""
+        vertices, faces = plane_grid
+        
+        output_vertices, output_faces = pyinstantmeshes.remesh_tiled(
+            vertices, faces, max_tile_faces=1000, target_edge_length=0.1,
+            deterministic=True
+        )
+        
+        assert len(output_faces) > 0
+        assert np.all(output_faces < len(output_vertices))
+        assert np.all(output_vertices[:, :2] >= -0.1)
+        assert np.all(output_vertices[:, :2] <= 1.1)
+    
+    def test_remesh_tiled_seams_welded(self, plane_grid):
+        """Test that no boundary edges are left along the tile seams."""
+        vertices, faces = plane_grid
+        
+        output_vertices, output_faces = pyinstantmeshes.remesh_tiled(
+            vertices, faces, max_tile_faces=1000, target_edge_length=0.1,
+            deterministic=True
+        )
+        
+        n = output_faces.shape[1]
+        edges = np.concatenate([output_faces[:, [i, (i + 1) % n]] for i in range(n)])
+        edges.sort(axis=1)
+        edges = edges[edges[:, 0] != edges[:, 1]]
+        unique, counts = np.unique(edges, axis=0, return_counts=True)
+        boundary = unique[counts == 1]
+        
+        # The 2x2 tiles meet along x = 0.5 and y = 0.5; only the border of
+        # the unit square may remain open
+        midpoints = output_vertices[boundary].mean(axis=1)[:, :2]
+        border_distance = np.minimum(midpoints, 1.0 - midpoints).min(axis=1)
+        assert len(boundary) > 0
+        assert np.all(border_distance < 0.2)
+    
+    def test_tile_grid_flat_margin(self, plane_grid):
+        """Test that the flat axis of a planar mesh does not limit the margin."""
+        vertices, _ = plane_grid
+        grid = _partition.TileGrid(*_partition.bounding_box(vertices), 4)
+        
+        assert list(grid.shape) == [2, 2, 1]
+        assert grid.max_margin() == pytest.approx(0.5)
+        assert _partition.TileGrid(*_partition.bounding_box(vertices), 1).max_margin() == np.inf
+        
+        near = grid.cells_near(np.array([[0.45, 0.25, 0.0]]), 0.2)
+        assert sorted(set(near[0]) - {-1}) == [0, 2]
+    
+    def test_weld_tiles(self, plane_grid):
+        """Test welding the four quarters of a grid back into one mesh."""
+        vertices, faces = plane_grid
+        rng = np.random.default_rng(0)
+        centroids = vertices[faces].mean(axis=1)
+        cells = (centroids[:, 0] > 0.5).astype(int) * 2 + (centroids[:, 1] > 0.5)
+        parts = []
+        for cell in range(4):
+            used, inverse = np.unique(faces[cells == cell], return_inverse=True)
+            jitter = rng.uniform(-1e-3, 1e-3, (len(used), 3)).astype(np.float32)
+            parts.append((vertices[used] + jitter,
+                          inverse.reshape(-1, 3).astype(np.int32)))
+        
+        output_vertices, output_faces = _partition.weld_tiles(parts, 0.01)
+        
+        assert output_vertices.dtype == np.float32
+        assert len(output_vertices) == len(vertices)
+        assert len(output_faces) == len(faces)
+        welded = output_vertices[output_faces].mean(axis=1)
+        assert np.allclose(np.sort(welded[:, 0]), np.sort(centroids[:, 0]), atol=2e-3)
+    
+    def test_remesh_tiled_memmap(self, plane_grid, tmp_path):
+        """Test remeshing memory-mapped input arrays."""
+        vertices, faces = plane_grid
+        np.save(tmp_path / "vertices.npy", vertices)
+        np.save(tmp_path / "faces.npy", faces)
+        
+        output_vertices, output_faces = pyinstantmeshes.remesh_tiled(
+            np.load(tmp_path / "vertices.npy", mmap_mode="r"),
+            np.load(tmp_path / "faces.npy", mmap_mode="r"),
+            max_tile_faces=1000, target_edge_length=0.1, deterministic=True
+        )
+        
+        assert len(output_faces) > 0
+        assert np.all(output_faces < len(output_vertices))
+    
+    def test_remesh_tiled_invalid_tile_size(self, plane_grid):
+        """Test remesh_tiled with a non-positive tile size."""
+        vertices, faces = plane_grid
+        
+        with pytest.raises(ValueError, match="max_tile_faces"):
+            pyinstantmeshes.remesh_tiled(vertices, faces, max_tile_faces=0)